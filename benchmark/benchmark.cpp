@@ -0,0 +1,265 @@
+/// Cycle accurate benchmark firmware.
+///
+/// Build and run it under simavr without a board attached:
+///
+///     pio run -e benchmark -t benchmark
+///
+/// Each benchmark prints a single JSON object per line on the serial port:
+///
+///     {"benchmark":"PIDController::compute","cycles":1234}
+///
+/// Cycles are counted by Timer1 running at the CPU clock with interrupts disabled, after subtracting the cost of
+/// the measurement itself. A cycle count of null means that the benchmark overflowed the 16 bit counter.
+
+#include "BiquadFilter.h"
+#include "CommunicationManager.h"
+#include "Encoder.h"
+#include "Gyroscope.h"
+#include "Motor.h"
+#include "PIDController.h"
+#include "Pipeline.h"
+#include "VelocityObserver.h"
+#include "configuration.h"
+#include "convert.h"
+#include <Arduino.h>
+#include <avr/sleep.h>
+
+#define BENCHMARK(name, statement)                                                                                     \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        cli();                                                                                                         \
+        TIFR1 = 1 << TOV1;                                                                                             \
+        TCNT1 = 0;                                                                                                     \
+        statement;                                                                                                     \
+        uint16_t cycles = TCNT1;                                                                                       \
+        bool overflow = TIFR1 & (1 << TOV1);                                                                           \
+        sei();                                                                                                         \
+        report(name, cycles, overflow);                                                                                \
+    } while (0)
+
+/// In memory stream replaying a single request.
+class ReplayStream : public Stream
+{
+  public:
+    void load(const char *data)
+    {
+        data_ = data;
+    }
+
+    int available() override
+    {
+        return *data_ != '\0';
+    }
+
+    int read() override
+    {
+        return *data_ != '\0' ? *data_++ : -1;
+    }
+
+    int peek() override
+    {
+        return *data_ != '\0' ? *data_ : -1;
+    }
+
+    size_t write(uint8_t) override
+    {
+        return 1;
+    }
+
+    int availableForWrite() override
+    {
+        return INT16_MAX;
+    }
+
+  private:
+    const char *data_ = "";
+};
+
+static uint16_t overhead = 0;
+
+static volatile float float_sink;
+static volatile bool bool_sink;
+
+static float value = 0;
+
+static Motor motor(PIN_MOTOR_L_FW, PIN_MOTOR_L_BW);
+static PIDController pid(1, static_cast<double>(INT8_MIN), static_cast<double>(INT8_MAX));
+
+/// Controller and actuator pair, timed against the same calls written out by hand.
+struct BenchmarkSignals
+{
+    float angle, duty;
+};
+
+struct BenchmarkController
+{
+    static const Rate RATE = Rate::CYCLE;
+
+    static inline bool run(BenchmarkSignals &signals)
+    {
+        if (!pid.compute(signals.angle))
+        {
+            return false;
+        }
+
+        signals.duty = pid.getOutput();
+        return true;
+    }
+};
+
+struct BenchmarkActuator
+{
+    static const Rate RATE = Rate::TRIGGERED;
+
+    static inline bool run(BenchmarkSignals &signals)
+    {
+        motor.setDuty(signals.duty);
+        return true;
+    }
+};
+
+typedef Pipeline<BenchmarkSignals, BenchmarkController, BenchmarkActuator> BenchmarkPipeline;
+
+static BenchmarkSignals signals{0.05, 0};
+
+/// Property names, kept in flash.
+static const char PROPERTY_BENCHMARK_VALUE[] PROGMEM = "benchmark.value";
+
+static Handler handlers[] = {
+    Handler{
+        .name = PROPERTY_BENCHMARK_VALUE,
+        .get =
+            [](char *buffer) {
+                doubleToString(value, 2, buffer);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double next = stringToDouble(buffer);
+                if (isnan(next)) return true;
+                value = next;
+                return false;
+            },
+    },
+};
+
+static void report(const char *name, uint16_t cycles, bool overflow)
+{
+    Serial.print("{\"benchmark\":\"");
+    Serial.print(name);
+    Serial.print("\",\"cycles\":");
+
+    if (overflow)
+    {
+        Serial.print("null");
+    }
+    else
+    {
+        Serial.print(cycles - overhead, DEC);
+    }
+
+    Serial.println('}');
+    Serial.flush();
+}
+
+void setup()
+{
+    Serial.begin(115200);
+
+    Gyroscope gyroscope(GYRO_ADDRESS, GYRO_ZERO_ANGLE, Gyroscope::Offset{0, 0, 0}, Gyroscope::Offset{0, 0, 0});
+    Encoder encoder(1, PIN_ENCODER_L_A, PIN_ENCODER_L_B, PIN_ENCODER_L_FW_LEVEL);
+    ReplayStream stream;
+    CommunicationManager comm_manager;
+
+    motor.begin();
+    comm_manager.begin(&stream, handlers);
+
+    pid.setKp(BALANCE_PID_KP);
+    pid.setKi(BALANCE_PID_KI);
+    pid.setKd(BALANCE_PID_KD);
+    pid.enable();
+
+    // Timer1 is configured for PWM by Motor::begin, switch it to a free running counter at the CPU clock.
+    TCCR1A = 0;
+    TCCR1B = 1 << CS10;
+
+    cli();
+    TCNT1 = 0;
+    overhead = TCNT1;
+    sei();
+
+#ifndef GYRO_RAW_ESTIMATOR
+    // The sensor is not simulated, the outputs are computed from a DMP packet about 3° off level, as an
+    // all zero packet would take the soft float fast paths.
+    static const uint8_t packet[] = {0x3F, 0xEF, 0xC5, 0x36, 0x00, 0x8E, 0x8A, 0xCA, 0xFE, 0x52, 0xBC, 0x33, 0x02, 0x3B,
+                                     0xCE, 0x97, 0x03, 0x5C, 0xFF, 0x88, 0x1F, 0xD6, 0x00, 0x0C, 0xFF, 0x10, 0x00, 0x05};
+    gyroscope._loadPacket(packet);
+#endif
+
+    BENCHMARK("Gyroscope::getAngle", float_sink = gyroscope.getAngle());
+    BENCHMARK("Gyroscope::getForwardAcceleration", float_sink = gyroscope.getForwardAcceleration());
+
+    // Let the sample period elapse so that the calculations are not skipped.
+    delay(2);
+    BENCHMARK("PIDController::compute", bool_sink = pid.compute(0.05));
+
+    BENCHMARK("Encoder::_onPulse", encoder._onPulse());
+
+#ifdef ENCODER_DIRECT_ISR
+    DirectEncoder<PIN_ENCODER_L_A, PIN_ENCODER_L_B, PIN_ENCODER_L_FW_LEVEL> direct_encoder(1);
+    BENCHMARK("DirectEncoder::_onInterrupt", direct_encoder._onInterrupt());
+#endif
+
+    delay(2);
+    BENCHMARK("Encoder::tick", bool_sink = encoder.tick());
+
+    BENCHMARK("Motor::setDuty", motor.setDuty(-42));
+
+    delay(2);
+    BENCHMARK("control pass (by hand)", if (pid.compute(0.05)) motor.setDuty(pid.getOutput()));
+
+    delay(2);
+    BENCHMARK("control pass (Pipeline::run)", bool_sink = BenchmarkPipeline::run(signals));
+
+    // Second order Butterworth low-pass at a tenth of the sample rate.
+    BiquadFilter filter(FILTER_ANGLE_SCALE);
+    filter.setSection(0, BiquadFilter::Section{1105, 2210, 1105, -18727, 6763});
+    BENCHMARK("BiquadFilter::process(1)", float_sink = filter.process(0.05));
+
+    // Notch at 0.15 of the sample rate.
+    filter.setSection(1, BiquadFilter::Section{15158, -17819, 15158, -17819, 13931});
+    BENCHMARK("BiquadFilter::process(2)", float_sink = filter.process(0.05));
+
+    VelocityObserver velocity_observer(WHEEL_TRAVEL_PER_REVOLUTION, VELOCITY_OBSERVER_GAIN_SHIFT,
+                                       VELOCITY_OBSERVER_BIAS_SHIFT);
+    velocity_observer.setWindow(ENCODER_SAMPLE_PERIOD);
+    velocity_observer.reset(0);
+    BENCHMARK("VelocityObserver::predict", velocity_observer.predict(0.5));
+    BENCHMARK("VelocityObserver::correct", velocity_observer.correct(1.25));
+
+    char number[] = "-123.45";
+    BENCHMARK("stringToDouble", float_sink = stringToDouble(number));
+
+    char long_number[] = "-0.000012345678901";
+    BENCHMARK("stringToDouble(long)", float_sink = stringToDouble(long_number));
+
+    char buffer[16];
+    BENCHMARK("doubleToString(2)", doubleToString(-123.45, 2, buffer));
+    BENCHMARK("doubleToString(8)", doubleToString(0.00012345, 8, buffer));
+
+    stream.load("benchmark.value=123.45\n");
+    BENCHMARK("CommunicationManager::tick(set)", comm_manager.tick());
+
+    stream.load("benchmark.value\n");
+    BENCHMARK("CommunicationManager::tick(get)", comm_manager.tick());
+
+    // Sleeping with interrupts disabled makes simavr exit.
+    cli();
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_enable();
+    sleep_cpu();
+}
+
+void loop()
+{
+}
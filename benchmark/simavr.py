@@ -0,0 +1,17 @@
+# Builds the benchmark harness in place of main.cpp and adds a "benchmark" target running it under simavr.
+
+Import("env")
+
+import os
+
+env.BuildSources(os.path.join("$BUILD_DIR", "benchmark"), os.path.join("$PROJECT_DIR", "benchmark"))
+
+simavr = os.path.join(env.PioPlatform().get_package_dir("tool-simavr"), "bin", "simavr")
+
+env.AddCustomTarget(
+    name="benchmark",
+    dependencies="$BUILD_DIR/${PROGNAME}.elf",
+    actions=['"%s" -m $BOARD_MCU -f $BOARD_F_CPU $BUILD_DIR/${PROGNAME}.elf' % simavr],
+    title="Benchmark",
+    description="Run the benchmark firmware under simavr",
+)
@@ -0,0 +1,257 @@
+#include "Client.h"
+
+#include <algorithm>
+#include <poll.h>
+
+struct Keyword
+{
+    Client::Status status;
+    const char *text;
+};
+
+static const Keyword KEYWORDS[] = {
+    {Client::Status::ERROR, "ERROR"},
+    {Client::Status::UNKNOWN, "UNKNOWN"},
+    {Client::Status::DENIED, "DENIED"},
+    {Client::Status::MALFORMED, "MALFORMED"},
+    {Client::Status::TIMEOUT, "TIMEOUT"},
+    {Client::Status::DISCONNECTED, "DISCONNECTED"},
+};
+
+Client::Client(int fd, size_t window, int timeout) : channel_(fd), window_(window), timeout_(timeout)
+{
+}
+
+void Client::get(const std::string &property, Callback callback, int timeout)
+{
+    request(property, callback, timeout);
+}
+
+void Client::set(const std::string &property, const std::string &value, Callback callback, int timeout)
+{
+    request(property + '=' + value, callback, timeout);
+}
+
+void Client::request(const std::string &line, Callback callback, int timeout)
+{
+    if (!connected_)
+    {
+        callback(Response{Status::DISCONNECTED, ""});
+        return;
+    }
+
+    std::chrono::milliseconds request_timeout = timeout != 0 ? std::chrono::milliseconds(timeout) : timeout_;
+    queued_.push_back(Request{line, callback, request_timeout, Clock::time_point()});
+}
+
+short Client::events() const
+{
+    return POLLIN | (channel_.wantsWrite() ? POLLOUT : 0);
+}
+
+int Client::timeout() const
+{
+    Clock::time_point deadline;
+
+    if (resyncing_)
+    {
+        deadline = std::min(quiet_deadline_, resync_deadline_);
+    }
+    else if (!in_flight_.empty())
+    {
+        deadline = in_flight_.front().sent + in_flight_.front().timeout;
+    }
+    else
+    {
+        return -1;
+    }
+
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+    return static_cast<int>(std::max<decltype(remaining)>(remaining + 1, 0));
+}
+
+void Client::handle(short revents)
+{
+    if (!connected_)
+    {
+        return;
+    }
+
+    if (revents & (POLLIN | POLLHUP | POLLERR))
+    {
+        if (!channel_.receive([this](const std::string &line) { onLine(line); }))
+        {
+            connected_ = false;
+            fail(Status::DISCONNECTED);
+            return;
+        }
+    }
+
+    checkTimeout();
+
+    if (resyncing_ && Clock::now() >= std::min(quiet_deadline_, resync_deadline_))
+    {
+        resyncing_ = false;
+    }
+
+    pump();
+
+    if (!channel_.flush())
+    {
+        connected_ = false;
+        fail(Status::DISCONNECTED);
+    }
+}
+
+void Client::poll(int timeout)
+{
+    // Queued requests are sent before waiting so that the responses are already on their way.
+    handle(0);
+
+    if (!connected_)
+    {
+        return;
+    }
+
+    int deadline = this->timeout();
+
+    if (deadline >= 0 && (timeout < 0 || deadline < timeout))
+    {
+        timeout = deadline;
+    }
+
+    pollfd descriptor{fd(), events(), 0};
+
+    if (::poll(&descriptor, 1, timeout) > 0)
+    {
+        handle(descriptor.revents);
+    }
+    else
+    {
+        handle(0);
+    }
+}
+
+void Client::wait()
+{
+    while (connected_ && !idle())
+    {
+        poll(-1);
+    }
+}
+
+Client::Response Client::parseResponse(const std::string &line)
+{
+    for (const Keyword &keyword : KEYWORDS)
+    {
+        if (line == keyword.text)
+        {
+            return Response{keyword.status, ""};
+        }
+    }
+
+    return Response{Status::OK, line};
+}
+
+std::string Client::formatResponse(const Response &response)
+{
+    for (const Keyword &keyword : KEYWORDS)
+    {
+        if (response.status == keyword.status)
+        {
+            return keyword.text;
+        }
+    }
+
+    return response.value;
+}
+
+void Client::pump()
+{
+    while (!resyncing_ && !queued_.empty())
+    {
+        size_t length = queued_.front().line.size() + 1;
+
+        // A request longer than the window is still sent once nothing else is in flight.
+        if (!in_flight_.empty() && in_flight_bytes_ + length > window_)
+        {
+            break;
+        }
+
+        Request request = std::move(queued_.front());
+        queued_.pop_front();
+
+        request.sent = Clock::now();
+        channel_.send(request.line);
+        in_flight_bytes_ += length;
+        in_flight_.push_back(std::move(request));
+    }
+}
+
+void Client::onLine(const std::string &line)
+{
+    // Streamed data is never a late response, it would keep a link that streams faster than the quiet time resyncing.
+    if (!line.empty() && line[0] == STREAM_PREFIX)
+    {
+        if (stream_handler_) stream_handler_(line);
+        return;
+    }
+
+    if (resyncing_)
+    {
+        quiet_deadline_ = Clock::now() + std::chrono::milliseconds(RESYNC_QUIET_TIME);
+        return;
+    }
+
+    // Nothing was asked, the line was left over from before the link was opened.
+    if (in_flight_.empty())
+    {
+        return;
+    }
+
+    Request request = std::move(in_flight_.front());
+    in_flight_.pop_front();
+    in_flight_bytes_ -= request.line.size() + 1;
+
+    request.callback(parseResponse(line));
+}
+
+void Client::fail(Status status)
+{
+    std::deque<Request> failed;
+    failed.swap(in_flight_);
+    in_flight_bytes_ = 0;
+
+    if (!connected_)
+    {
+        std::move(queued_.begin(), queued_.end(), std::back_inserter(failed));
+        queued_.clear();
+    }
+
+    // The callbacks may queue new requests, which must not be failed along.
+    for (Request &request : failed)
+    {
+        request.callback(Response{status, ""});
+    }
+}
+
+void Client::checkTimeout()
+{
+    if (in_flight_.empty())
+    {
+        return;
+    }
+
+    const Request &oldest = in_flight_.front();
+
+    if (Clock::now() < oldest.sent + oldest.timeout)
+    {
+        return;
+    }
+
+    // A late response would be matched to the wrong request, wait for the link to go quiet first.
+    resyncing_ = true;
+    quiet_deadline_ = Clock::now() + std::chrono::milliseconds(RESYNC_QUIET_TIME);
+    resync_deadline_ = Clock::now() + std::chrono::milliseconds(RESYNC_MAX_TIME);
+    fail(Status::TIMEOUT);
+}
@@ -0,0 +1,160 @@
+/// Host client library for the CommunicationManager protocol.
+///
+/// Requests are pipelined: they are written as soon as the window allows and the responses, which the firmware sends
+/// in request order, are matched to them in order. Lines starting with STREAM_PREFIX are streamed data and are passed
+/// to the stream handler instead.
+///
+/// The firmware drops bytes that overflow its receive buffer, which would shift every later match. The window keeps
+/// the bytes in flight within the receive buffer, and when a response times out all the requests in flight fail and
+/// the link is left to go quiet before sending resumes.
+
+#ifndef _CLIENT_H_
+#define _CLIENT_H_
+
+#include "LineChannel.h"
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <string>
+
+class Client
+{
+  public:
+    enum class Status
+    {
+        OK,
+        ERROR,
+        UNKNOWN,
+        DENIED,
+        MALFORMED,
+        TIMEOUT,
+        DISCONNECTED,
+    };
+
+    struct Response
+    {
+        Status status;
+
+        /// Property value for a get, "OK" for a set, empty on failure.
+        std::string value;
+    };
+
+    typedef std::function<void(const Response &response)> Callback;
+    typedef std::function<void(const std::string &line)> StreamHandler;
+
+    /// Prefix of the lines carrying streamed data.
+    static const char STREAM_PREFIX = '#';
+
+    /// [bytes] Window fitting the firmware receive buffer, for direct serial links.
+    static const size_t SERIAL_WINDOW = 63;
+
+    /// [bytes] Window for links to the daemon, which does its own windowing.
+    static const size_t DAEMON_WINDOW = 4096;
+
+    /// [ms] Default time to wait for a response.
+    static const int DEFAULT_TIMEOUT = 1000;
+
+    /// Take ownership of a non-blocking descriptor.
+    Client(int fd, size_t window = SERIAL_WINDOW, int timeout = DEFAULT_TIMEOUT);
+
+    Client(const Client &) = delete;
+    Client &operator=(const Client &) = delete;
+
+    /// Queue a read of a property, timeout [ms] overrides the default when not zero.
+    void get(const std::string &property, Callback callback, int timeout = 0);
+
+    /// Queue a write of a property, timeout [ms] overrides the default when not zero.
+    void set(const std::string &property, const std::string &value, Callback callback, int timeout = 0);
+
+    /// Queue a raw request line, timeout [ms] overrides the default when not zero.
+    void request(const std::string &line, Callback callback, int timeout = 0);
+
+    /// Set the handler receiving the streamed data lines.
+    inline void onStream(StreamHandler handler)
+    {
+        stream_handler_ = handler;
+    }
+
+    /// Whether no request is queued or waiting for its response.
+    inline bool idle() const
+    {
+        return queued_.empty() && in_flight_.empty();
+    }
+
+    inline bool connected() const
+    {
+        return connected_;
+    }
+
+    /// Descriptor to poll when the client is driven from an external event loop.
+    inline int fd() const
+    {
+        return channel_.fd();
+    }
+
+    /// Events to poll for.
+    short events() const;
+
+    /// [ms] Time until the next timer expires, -1 if none is running.
+    int timeout() const;
+
+    /// Process the events returned by poll, zero if the poll timed out.
+    void handle(short revents);
+
+    /// Wait up to timeout [ms] for events and process them, -1 waits indefinitely.
+    void poll(int timeout);
+
+    /// Process events until every request has completed.
+    void wait();
+
+    /// Parse a response line.
+    static Response parseResponse(const std::string &line);
+
+    /// Format a response as the firmware would, TIMEOUT and DISCONNECTED are only produced by the daemon.
+    static std::string formatResponse(const Response &response);
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+
+    /// [ms] Silence needed on the link before sending resumes after a timeout, streamed data does not count.
+    static constexpr int RESYNC_QUIET_TIME = 100;
+
+    /// [ms] Longest wait for the link to go quiet, sending resumes anyway once it has elapsed.
+    static constexpr int RESYNC_MAX_TIME = 1000;
+
+    struct Request
+    {
+        std::string line;
+        Callback callback;
+        std::chrono::milliseconds timeout;
+        Clock::time_point sent;
+    };
+
+    LineChannel channel_;
+    size_t window_;
+    std::chrono::milliseconds timeout_;
+    bool connected_ = true;
+
+    std::deque<Request> queued_, in_flight_;
+    size_t in_flight_bytes_ = 0;
+
+    bool resyncing_ = false;
+    Clock::time_point quiet_deadline_, resync_deadline_;
+
+    StreamHandler stream_handler_;
+
+    /// Send the queued requests that fit in the window.
+    void pump();
+
+    /// Match a received line to the oldest request in flight.
+    void onLine(const std::string &line);
+
+    /// Fail the requests in flight, and the queued ones too if the link is gone.
+    void fail(Status status);
+
+    /// Fail the requests in flight and wait for the link to go quiet if the oldest one timed out.
+    void checkTimeout();
+};
+
+#endif // _CLIENT_H_
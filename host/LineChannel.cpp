@@ -0,0 +1,71 @@
+#include "LineChannel.h"
+
+#include <cerrno>
+#include <unistd.h>
+
+LineChannel::LineChannel(int fd) : fd_(fd)
+{
+}
+
+LineChannel::~LineChannel()
+{
+    close(fd_);
+}
+
+bool LineChannel::receive(const LineHandler &handler)
+{
+    char buffer[512];
+
+    for (;;)
+    {
+        ssize_t length = read(fd_, buffer, sizeof(buffer));
+
+        if (length == 0)
+        {
+            return false;
+        }
+
+        if (length < 0)
+        {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+
+        for (ssize_t i = 0; i < length; i++)
+        {
+            char next = buffer[i];
+
+            if (next == '\n')
+            {
+                handler(input_);
+                input_.clear();
+            }
+            else if (next != '\r' && input_.size() < MAX_LINE_LENGTH)
+            {
+                input_ += next;
+            }
+        }
+    }
+}
+
+void LineChannel::send(const std::string &line)
+{
+    output_ += line;
+    output_ += '\n';
+}
+
+bool LineChannel::flush()
+{
+    while (!output_.empty())
+    {
+        ssize_t length = write(fd_, output_.data(), output_.size());
+
+        if (length < 0)
+        {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+
+        output_.erase(0, length);
+    }
+
+    return true;
+}
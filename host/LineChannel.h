@@ -0,0 +1,51 @@
+/// Line oriented wrapper around a non-blocking file descriptor.
+
+#ifndef _LINE_CHANNEL_H_
+#define _LINE_CHANNEL_H_
+
+#include <functional>
+#include <string>
+
+class LineChannel
+{
+  public:
+    typedef std::function<void(const std::string &line)> LineHandler;
+
+    /// Take ownership of a non-blocking descriptor.
+    explicit LineChannel(int fd);
+    ~LineChannel();
+
+    LineChannel(const LineChannel &) = delete;
+    LineChannel &operator=(const LineChannel &) = delete;
+
+    inline int fd() const
+    {
+        return fd_;
+    }
+
+    /// Read the available bytes and pass each complete line to the handler, without its delimiter.
+    /// Returns false once the peer has closed or on error.
+    bool receive(const LineHandler &handler);
+
+    /// Queue a line for writing, the delimiter is appended.
+    void send(const std::string &line);
+
+    /// Write as much of the queued output as the descriptor accepts.
+    /// Returns false on error.
+    bool flush();
+
+    /// Whether output is waiting for the descriptor to become writable.
+    inline bool wantsWrite() const
+    {
+        return !output_.empty();
+    }
+
+  private:
+    /// Longest line kept, longer lines are truncated.
+    static const size_t MAX_LINE_LENGTH = 4096;
+
+    int fd_;
+    std::string input_, output_;
+};
+
+#endif // _LINE_CHANNEL_H_
@@ -0,0 +1,161 @@
+#include "Transport.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <system_error>
+#include <termios.h>
+#include <unistd.h>
+
+static speed_t toSpeed(uint32_t baud_rate)
+{
+    switch (baud_rate)
+    {
+    case 1200:
+        return B1200;
+    case 2400:
+        return B2400;
+    case 4800:
+        return B4800;
+    case 9600:
+        return B9600;
+    case 19200:
+        return B19200;
+    case 38400:
+        return B38400;
+    case 57600:
+        return B57600;
+    case 115200:
+        return B115200;
+    case 230400:
+        return B230400;
+#ifdef B500000
+    case 500000:
+        return B500000;
+#endif
+#ifdef B1000000
+    case 1000000:
+        return B1000000;
+#endif
+    default:
+        throw std::invalid_argument("unsupported baud rate " + std::to_string(baud_rate));
+    }
+}
+
+static std::system_error systemError(const std::string &what)
+{
+    return std::system_error(errno, std::generic_category(), what);
+}
+
+static sockaddr_un socketAddress(const std::string &path)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+
+    if (path.size() >= sizeof(address.sun_path))
+    {
+        throw std::invalid_argument("socket path too long: " + path);
+    }
+
+    std::strcpy(address.sun_path, path.c_str());
+    return address;
+}
+
+int openSerialPort(const std::string &path, uint32_t baud_rate)
+{
+    speed_t speed = toSpeed(baud_rate);
+    int fd = open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+
+    if (fd < 0)
+    {
+        throw systemError("open " + path);
+    }
+
+    termios options;
+
+    if (tcgetattr(fd, &options) < 0)
+    {
+        int error = errno;
+        close(fd);
+        errno = error;
+        throw systemError("tcgetattr " + path);
+    }
+
+    cfmakeraw(&options);
+    cfsetispeed(&options, speed);
+    cfsetospeed(&options, speed);
+
+    // Keep DTR up on close, dropping it resets the board.
+    options.c_cflag &= ~HUPCL;
+    options.c_cflag |= CLOCAL | CREAD;
+
+    if (tcsetattr(fd, TCSANOW, &options) < 0)
+    {
+        int error = errno;
+        close(fd);
+        errno = error;
+        throw systemError("tcsetattr " + path);
+    }
+
+    tcflush(fd, TCIOFLUSH);
+    return fd;
+}
+
+int connectSocket(const std::string &path)
+{
+    sockaddr_un address = socketAddress(path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd < 0)
+    {
+        throw systemError("socket");
+    }
+
+    if (connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0)
+    {
+        int error = errno;
+        close(fd);
+        errno = error;
+        throw systemError("connect " + path);
+    }
+
+    setNonBlocking(fd);
+    return fd;
+}
+
+int listenSocket(const std::string &path)
+{
+    sockaddr_un address = socketAddress(path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd < 0)
+    {
+        throw systemError("socket");
+    }
+
+    unlink(path.c_str());
+
+    if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 || listen(fd, 16) < 0)
+    {
+        int error = errno;
+        close(fd);
+        errno = error;
+        throw systemError("listen " + path);
+    }
+
+    setNonBlocking(fd);
+    return fd;
+}
+
+void setNonBlocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL);
+
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+    {
+        throw systemError("fcntl");
+    }
+}
@@ -0,0 +1,25 @@
+/// Host side transports to the robot: serial ports and local Unix sockets.
+
+#ifndef _TRANSPORT_H_
+#define _TRANSPORT_H_
+
+#include <cstdint>
+#include <string>
+
+/// Open a serial port in raw, non-blocking mode.
+/// Throws std::system_error if the port cannot be opened, std::invalid_argument if the baud rate is not supported.
+int openSerialPort(const std::string &path, uint32_t baud_rate);
+
+/// Connect to the daemon listening on the given Unix socket, the descriptor is non-blocking.
+/// Throws std::system_error on failure.
+int connectSocket(const std::string &path);
+
+/// Listen on the given Unix socket, replacing any stale socket file, the descriptor is non-blocking.
+/// Throws std::system_error on failure.
+int listenSocket(const std::string &path);
+
+/// Make a descriptor non-blocking.
+/// Throws std::system_error on failure.
+void setNonBlocking(int fd);
+
+#endif // _TRANSPORT_H_
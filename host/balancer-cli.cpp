@@ -0,0 +1,90 @@
+/// Command line client.
+///
+/// Sends every request given on the command line at once and prints each response next to its request, then prints
+/// the streamed data lines for the given number of seconds.
+///
+///     balancer-cli (-s socket | -d serial port [-b baud]) [-f seconds] [request ...]
+
+#include "Client.h"
+#include "Transport.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+static void usage()
+{
+    fprintf(stderr, "usage: balancer-cli (-s socket | -d serial port [-b baud]) [-f seconds] [request ...]\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    const char *socket_path = nullptr;
+    const char *serial_path = nullptr;
+    uint32_t baud_rate = 9600;
+    double follow = 0;
+    int option;
+
+    while ((option = getopt(argc, argv, "s:d:b:f:")) != -1)
+    {
+        switch (option)
+        {
+        case 's':
+            socket_path = optarg;
+            break;
+        case 'd':
+            serial_path = optarg;
+            break;
+        case 'b':
+            baud_rate = strtoul(optarg, nullptr, 10);
+            break;
+        case 'f':
+            follow = atof(optarg);
+            break;
+        default:
+            usage();
+        }
+    }
+
+    if ((socket_path == nullptr) == (serial_path == nullptr))
+    {
+        usage();
+    }
+
+    try
+    {
+        Client client(socket_path != nullptr ? connectSocket(socket_path) : openSerialPort(serial_path, baud_rate),
+                      socket_path != nullptr ? Client::DAEMON_WINDOW : Client::SERIAL_WINDOW);
+        int failures = 0;
+
+        for (int i = optind; i < argc; i++)
+        {
+            std::string request = argv[i];
+
+            client.request(request, [request, &failures](const Client::Response &response) {
+                printf("%s -> %s\n", request.c_str(), Client::formatResponse(response).c_str());
+                if (response.status != Client::Status::OK) failures++;
+            });
+        }
+
+        client.wait();
+
+        client.onStream([](const std::string &line) { printf("%s\n", line.c_str()); });
+
+        auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(follow);
+
+        while (client.connected() && std::chrono::steady_clock::now() < end)
+        {
+            client.poll(100);
+        }
+
+        return failures != 0;
+    }
+    catch (const std::exception &error)
+    {
+        fprintf(stderr, "balancer-cli: %s\n", error.what());
+        return 1;
+    }
+}
@@ -0,0 +1,250 @@
+/// Serial link multiplexer.
+///
+/// Owns the robot's serial port and serves any number of local clients on a Unix socket, speaking the same line
+/// protocol as the firmware. Requests from all the clients are pipelined onto the link, each client receives its
+/// responses in the order of its own requests, and streamed data lines are sent to every client.
+///
+/// A read of a property that is already waiting for its value is not sent again, the pending response is shared
+/// instead. A write of the property ends the sharing so that later reads observe it.
+///
+///     balancerd [-b baud] [-w window] [-t timeout] <serial port> <socket>
+
+#include "Client.h"
+#include "LineChannel.h"
+#include "Transport.h"
+
+#include <cctype>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+/// Response slot, filled when the response arrives and sent once every earlier slot of its session was.
+struct Slot
+{
+    bool done = false;
+    std::string line;
+};
+
+typedef std::vector<std::shared_ptr<Slot>> Waiters;
+
+struct Session
+{
+    std::unique_ptr<LineChannel> channel;
+    std::deque<std::shared_ptr<Slot>> slots;
+};
+
+static std::map<uint32_t, Session> sessions;
+static uint32_t next_session_id = 0;
+
+/// Reads waiting for their response, by normalized property name.
+static std::map<std::string, std::shared_ptr<Waiters>> pending_reads;
+
+/// Send the responses that are ready, in request order.
+static void flushSlots()
+{
+    for (auto &entry : sessions)
+    {
+        Session &session = entry.second;
+
+        while (!session.slots.empty() && session.slots.front()->done)
+        {
+            session.channel->send(session.slots.front()->line);
+            session.slots.pop_front();
+        }
+    }
+}
+
+/// Apply the firmware's rules: whitespace is ignored and names are case insensitive.
+static std::string normalize(const std::string &line)
+{
+    std::string normalized;
+
+    for (char next : line)
+    {
+        if (!std::isspace(static_cast<unsigned char>(next)))
+        {
+            normalized += std::tolower(static_cast<unsigned char>(next));
+        }
+    }
+
+    return normalized;
+}
+
+static void onRequest(Client &upstream, Session &session, const std::string &line)
+{
+    std::string request = normalize(line);
+    auto slot = std::make_shared<Slot>();
+    session.slots.push_back(slot);
+
+    size_t delimiter = request.find('=');
+
+    if (delimiter != std::string::npos)
+    {
+        pending_reads.erase(request.substr(0, delimiter));
+
+        upstream.request(request, [slot](const Client::Response &response) {
+            slot->done = true;
+            slot->line = Client::formatResponse(response);
+        });
+
+        return;
+    }
+
+    auto pending = pending_reads.find(request);
+
+    if (pending != pending_reads.end() && !request.empty())
+    {
+        pending->second->push_back(slot);
+        return;
+    }
+
+    auto waiters = std::make_shared<Waiters>(1, slot);
+    pending_reads[request] = waiters;
+
+    upstream.request(request, [request, waiters](const Client::Response &response) {
+        std::string line = Client::formatResponse(response);
+
+        for (auto &waiter : *waiters)
+        {
+            waiter->done = true;
+            waiter->line = line;
+        }
+
+        auto pending = pending_reads.find(request);
+
+        if (pending != pending_reads.end() && pending->second == waiters)
+        {
+            pending_reads.erase(pending);
+        }
+    });
+}
+
+static void usage()
+{
+    fprintf(stderr, "usage: balancerd [-b baud] [-w window] [-t timeout] <serial port> <socket>\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t baud_rate = 9600;
+    size_t window = Client::SERIAL_WINDOW;
+    int timeout = Client::DEFAULT_TIMEOUT;
+    int option;
+
+    while ((option = getopt(argc, argv, "b:w:t:")) != -1)
+    {
+        switch (option)
+        {
+        case 'b':
+            baud_rate = strtoul(optarg, nullptr, 10);
+            break;
+        case 'w':
+            window = strtoul(optarg, nullptr, 10);
+            break;
+        case 't':
+            timeout = atoi(optarg);
+            break;
+        default:
+            usage();
+        }
+    }
+
+    if (argc - optind != 2)
+    {
+        usage();
+    }
+
+    // A client may close its socket before the data sent to it is flushed, the write then fails with EPIPE and ends
+    // its session instead of raising SIGPIPE.
+    signal(SIGPIPE, SIG_IGN);
+
+    try
+    {
+        Client upstream(openSerialPort(argv[optind], baud_rate), window, timeout);
+        LineChannel listener(listenSocket(argv[optind + 1]));
+
+        upstream.onStream([](const std::string &line) {
+            for (auto &entry : sessions)
+            {
+                entry.second.channel->send(line);
+            }
+        });
+
+        while (upstream.connected())
+        {
+            std::vector<pollfd> descriptors;
+            descriptors.push_back(pollfd{listener.fd(), POLLIN, 0});
+            descriptors.push_back(pollfd{upstream.fd(), upstream.events(), 0});
+
+            for (auto &entry : sessions)
+            {
+                LineChannel &channel = *entry.second.channel;
+                short events = POLLIN | (channel.wantsWrite() ? POLLOUT : 0);
+                descriptors.push_back(pollfd{channel.fd(), events, 0});
+            }
+
+            if (poll(descriptors.data(), descriptors.size(), upstream.timeout()) < 0)
+            {
+                continue;
+            }
+
+            if (descriptors[0].revents & POLLIN)
+            {
+                int fd = accept(listener.fd(), nullptr, nullptr);
+
+                if (fd >= 0)
+                {
+                    setNonBlocking(fd);
+                    sessions[next_session_id++].channel.reset(new LineChannel(fd));
+                }
+            }
+
+            // Sessions are walked in the same order as their descriptors were added.
+            size_t index = 2;
+
+            for (auto entry = sessions.begin(); entry != sessions.end() && index < descriptors.size(); index++)
+            {
+                Session &session = entry->second;
+                bool open = true;
+
+                if (descriptors[index].revents & (POLLIN | POLLHUP | POLLERR))
+                {
+                    open = session.channel->receive(
+                        [&](const std::string &line) { onRequest(upstream, session, line); });
+                }
+
+                if (open)
+                {
+                    ++entry;
+                }
+                else
+                {
+                    entry = sessions.erase(entry);
+                }
+            }
+
+            upstream.handle(descriptors[1].revents);
+            flushSlots();
+
+            for (auto entry = sessions.begin(); entry != sessions.end();)
+            {
+                entry = entry->second.channel->flush() ? std::next(entry) : sessions.erase(entry);
+            }
+        }
+
+        fprintf(stderr, "balancerd: serial port closed\n");
+        return 1;
+    }
+    catch (const std::exception &error)
+    {
+        fprintf(stderr, "balancerd: %s\n", error.what());
+        return 1;
+    }
+}
@@ -0,0 +1,249 @@
+/// Firmware stand-in on a pseudo terminal.
+///
+/// Answers the CommunicationManager protocol with a small set of properties, so that the client library and the
+/// daemon can be exercised on Linux without a board. Like the firmware, it only services the link once per loop
+/// cycle, drops the bytes that overflow its receive buffer and blocks while gyroscope.calibrate runs.
+///
+/// stream.rate only exists in the emulator: setting it streams "#<ms>,<value>" lines at that rate [Hz], standing in
+/// for the firmware's streamed data.
+///
+///     balancer-emulator [-r receive buffer] [-p loop period] [-l link]
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+
+struct Property
+{
+    const char *name;
+    std::string value;
+    bool readable, writable;
+
+    /// [ms] Time a write blocks the loop.
+    int block_time;
+};
+
+static Property properties[] = {
+    {"balance-pid.kp", "8.00", true, true, 0},
+    {"balance-pid.ki", "0.00", true, true, 0},
+    {"balance-pid.kd", "0.10", true, true, 0},
+    {"gyroscope.zero-angle", "-0.08", true, true, 0},
+    {"gyroscope.calibrate", "", false, true, 2700},
+    {"battery.voltage", "7.40", true, false, 0},
+    {"irq.reset", "", false, true, 0},
+    {"stream.rate", "0", true, true, 0},
+};
+
+/// [ms] Time the loop blocks once the current packet has been answered.
+static int block_time = 0;
+
+/// Maximum length of a packet in bytes, as in CommunicationManager.
+static const size_t PACKET_SIZE = 64;
+
+static Property *findProperty(const std::string &name)
+{
+    for (Property &property : properties)
+    {
+        if (strcasecmp(property.name, name.c_str()) == 0)
+        {
+            return &property;
+        }
+    }
+
+    return nullptr;
+}
+
+/// Answer a packet, without its delimiter, following CommunicationManager::handleRequest.
+static std::string handlePacket(const std::string &packet)
+{
+    if (packet.empty() || packet.size() >= PACKET_SIZE)
+    {
+        return "MALFORMED";
+    }
+
+    size_t delimiter = packet.find('=');
+
+    if (delimiter != std::string::npos && packet.find('=', delimiter + 1) != std::string::npos)
+    {
+        return "MALFORMED";
+    }
+
+    for (char next : packet)
+    {
+        if (!isascii(next))
+        {
+            return "MALFORMED";
+        }
+    }
+
+    Property *property = findProperty(packet.substr(0, delimiter));
+
+    if (property == nullptr)
+    {
+        return "UNKNOWN";
+    }
+
+    if (delimiter != std::string::npos && property->writable)
+    {
+        std::string payload = packet.substr(delimiter + 1);
+        char *end;
+        strtod(payload.c_str(), &end);
+
+        if (payload.empty() || *end != '\0')
+        {
+            return "ERROR";
+        }
+
+        property->value = payload;
+        block_time = property->block_time;
+        return "OK";
+    }
+
+    if (delimiter == std::string::npos && property->readable)
+    {
+        return property->value;
+    }
+
+    return "DENIED";
+}
+
+static void usage()
+{
+    fprintf(stderr, "usage: balancer-emulator [-r receive buffer] [-p loop period] [-l link]\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    // Arduino serial receive buffer and a loop cycle slowed down by a few serial requests.
+    size_t receive_buffer_size = 64;
+    int loop_period = 5;
+    const char *link_path = nullptr;
+    int option;
+
+    while ((option = getopt(argc, argv, "r:p:l:")) != -1)
+    {
+        switch (option)
+        {
+        case 'r':
+            receive_buffer_size = strtoul(optarg, nullptr, 10);
+            break;
+        case 'p':
+            loop_period = atoi(optarg);
+            break;
+        case 'l':
+            link_path = optarg;
+            break;
+        default:
+            usage();
+        }
+    }
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0)
+    {
+        perror("balancer-emulator: posix_openpt");
+        return 1;
+    }
+
+    const char *slave_path = ptsname(master);
+
+    // Holding the slave open keeps the master readable while no client is attached.
+    int slave = open(slave_path, O_RDWR | O_NOCTTY);
+    termios options;
+    tcgetattr(slave, &options);
+    cfmakeraw(&options);
+    tcsetattr(slave, TCSANOW, &options);
+
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+
+    if (link_path != nullptr)
+    {
+        unlink(link_path);
+
+        if (symlink(slave_path, link_path) < 0)
+        {
+            perror("balancer-emulator: symlink");
+            return 1;
+        }
+    }
+
+    printf("%s\n", slave_path);
+    fflush(stdout);
+
+    auto start = std::chrono::steady_clock::now();
+    auto last_stream = start;
+    std::string receive_buffer, packet;
+
+    for (;;)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(loop_period));
+
+        char buffer[256];
+        ssize_t length;
+
+        while ((length = read(master, buffer, sizeof(buffer))) > 0)
+        {
+            size_t space = receive_buffer_size - std::min(receive_buffer.size(), receive_buffer_size);
+            receive_buffer.append(buffer, std::min<size_t>(length, space));
+        }
+
+        std::string output;
+
+        for (char next : receive_buffer)
+        {
+            if (next != '\n' && next != '=' && isspace(next))
+            {
+                continue;
+            }
+
+            if (next == '\n')
+            {
+                output += handlePacket(packet) + '\n';
+                packet.clear();
+
+                // The response is only written once the loop is back, as the firmware's handler does not return
+                // before.
+                if (block_time > 0)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(block_time));
+                    block_time = 0;
+                }
+            }
+            else if (packet.size() < PACKET_SIZE)
+            {
+                packet += next;
+            }
+        }
+
+        receive_buffer.clear();
+
+        auto now = std::chrono::steady_clock::now();
+        double rate = atof(findProperty("stream.rate")->value.c_str());
+
+        if (rate > 0 && now - last_stream >= std::chrono::duration<double>(1 / rate))
+        {
+            double elapsed = std::chrono::duration<double>(now - start).count();
+            output += "#" + std::to_string(static_cast<long>(elapsed * 1000)) + "," +
+                      std::to_string(std::sin(elapsed)) + "\n";
+            last_stream = now;
+        }
+
+        if (!output.empty() && write(master, output.data(), output.size()) < 0)
+        {
+            perror("balancer-emulator: write");
+        }
+    }
+
+    close(slave);
+}
@@ -0,0 +1,293 @@
+/// System identification model fitter.
+///
+/// Reads the samples streamed by the firmware while sysid.enable is set, as printed by balancer-cli -f, and fits by
+/// least squares:
+///
+/// - pendulum: the linearized inclination dynamics, angle_rate' = a * angle + b * duty + c, in rad and seconds.
+///   b is the duty gain of the inclination predictor.
+/// - angle_arx: angle[k+1] = a1 * angle[k] + a2 * angle[k-1] + b1 * duty[k] + b2 * duty[k-1], at the balance
+///   loop rate.
+/// - speed_arx: speed[j+1] = a1 * speed[j] + b1 * duty[j] + c1 * angle[j], speed in wheel revolutions per second
+///   averaged over the decimated period, duty and angle averaged over it too.
+///
+/// Samples lost to a full serial buffer are detected from the sample count and never bridged by a regression.
+/// The model is written as JSON on the standard output.
+///
+///     sysid-fit [-t sample period ms] [-e pulses per revolution] [-d speed decimation] [log]
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+struct Sample
+{
+    long index;
+    double angle, angle_rate, duty, excitation, position;
+};
+
+/// Linear regression problem, one row of regressors per target.
+struct Regression
+{
+    std::vector<std::vector<double>> rows;
+    std::vector<double> targets;
+
+    void add(const std::vector<double> &row, double target)
+    {
+        rows.push_back(row);
+        targets.push_back(target);
+    }
+};
+
+struct Fit
+{
+    std::vector<double> coefficients;
+    double rms;
+};
+
+/// Solve the normal equations by Gaussian elimination with partial pivoting.
+static Fit leastSquares(const Regression &regression)
+{
+    if (regression.rows.empty())
+    {
+        throw std::runtime_error("not enough contiguous samples");
+    }
+
+    size_t n = regression.rows[0].size();
+    std::vector<std::vector<double>> matrix(n, std::vector<double>(n + 1, 0));
+
+    for (size_t r = 0; r < regression.rows.size(); r++)
+    {
+        const std::vector<double> &row = regression.rows[r];
+
+        for (size_t i = 0; i < n; i++)
+        {
+            for (size_t j = 0; j < n; j++)
+            {
+                matrix[i][j] += row[i] * row[j];
+            }
+
+            matrix[i][n] += row[i] * regression.targets[r];
+        }
+    }
+
+    for (size_t column = 0; column < n; column++)
+    {
+        size_t pivot = column;
+
+        for (size_t i = column + 1; i < n; i++)
+        {
+            if (std::fabs(matrix[i][column]) > std::fabs(matrix[pivot][column])) pivot = i;
+        }
+
+        if (std::fabs(matrix[pivot][column]) < 1e-12)
+        {
+            throw std::runtime_error("the regressors are not independent, is the excitation enabled?");
+        }
+
+        std::swap(matrix[column], matrix[pivot]);
+
+        for (size_t i = 0; i < n; i++)
+        {
+            if (i == column) continue;
+            double factor = matrix[i][column] / matrix[column][column];
+
+            for (size_t j = column; j <= n; j++)
+            {
+                matrix[i][j] -= factor * matrix[column][j];
+            }
+        }
+    }
+
+    Fit fit;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        fit.coefficients.push_back(matrix[i][n] / matrix[i][i]);
+    }
+
+    double squares = 0;
+
+    for (size_t r = 0; r < regression.rows.size(); r++)
+    {
+        double prediction = 0;
+
+        for (size_t i = 0; i < n; i++)
+        {
+            prediction += fit.coefficients[i] * regression.rows[r][i];
+        }
+
+        squares += std::pow(regression.targets[r] - prediction, 2);
+    }
+
+    fit.rms = std::sqrt(squares / regression.rows.size());
+    return fit;
+}
+
+/// Parse "#<sample>,<angle>,<angle rate>,<duty>,<excitation>,<left position>,<right position>" lines, with the angle
+/// in 0.1 mrad and its rate in mrad/s, anything else is skipped.
+static std::vector<Sample> readSamples(std::istream &input)
+{
+    std::vector<Sample> samples;
+    std::string line;
+
+    while (std::getline(input, line))
+    {
+        if (line.empty() || line[0] != '#')
+        {
+            continue;
+        }
+
+        long index, angle, angle_rate, duty, excitation, left, right;
+
+        if (sscanf(line.c_str(), "#%ld,%ld,%ld,%ld,%ld,%ld,%ld", &index, &angle, &angle_rate, &duty, &excitation,
+                   &left, &right) != 7)
+        {
+            continue;
+        }
+
+        samples.push_back(Sample{index, angle / 10000.0, angle_rate / 1000.0, static_cast<double>(duty),
+                                 static_cast<double>(excitation), (left + right) / 2.0});
+    }
+
+    return samples;
+}
+
+/// Whether the samples from first to last are consecutive.
+static bool contiguous(const std::vector<Sample> &samples, size_t first, size_t last)
+{
+    return samples[last].index - samples[first].index == static_cast<long>(last - first);
+}
+
+static void printFit(const char *name, const std::vector<const char *> &keys, const Fit &fit, bool last)
+{
+    printf("  \"%s\": {", name);
+
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        printf("\"%s\": %.6g, ", keys[i], fit.coefficients[i]);
+    }
+
+    printf("\"rms\": %.6g}%s\n", fit.rms, last ? "" : ",");
+}
+
+static void usage()
+{
+    fprintf(stderr, "usage: sysid-fit [-t sample period ms] [-e pulses per revolution] [-d speed decimation] [log]\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    // Defaults of BALANCE_PID_SAMPLE_PERIOD, ENCODER_PULSES_PER_REVOLUTION and VELOCITY_PID_SAMPLE_PERIOD.
+    double period = 0.010;
+    double pulses_per_revolution = 8;
+    size_t decimation = 10;
+    int option;
+
+    while ((option = getopt(argc, argv, "t:e:d:")) != -1)
+    {
+        switch (option)
+        {
+        case 't':
+            period = atof(optarg) / 1000;
+            break;
+        case 'e':
+            pulses_per_revolution = atof(optarg);
+            break;
+        case 'd':
+            decimation = strtoul(optarg, nullptr, 10);
+            break;
+        default:
+            usage();
+        }
+    }
+
+    if (argc - optind > 1 || decimation == 0 || period <= 0)
+    {
+        usage();
+    }
+
+    std::vector<Sample> samples;
+
+    if (optind < argc)
+    {
+        std::ifstream input(argv[optind]);
+
+        if (!input)
+        {
+            fprintf(stderr, "sysid-fit: cannot open %s\n", argv[optind]);
+            return 1;
+        }
+
+        samples = readSamples(input);
+    }
+    else
+    {
+        samples = readSamples(std::cin);
+    }
+
+    Regression pendulum, angle_arx, speed_arx;
+
+    for (size_t k = 1; k + 1 < samples.size(); k++)
+    {
+        if (!contiguous(samples, k - 1, k + 1))
+        {
+            continue;
+        }
+
+        const Sample &previous = samples[k - 1], &current = samples[k], &next = samples[k + 1];
+
+        pendulum.add({current.angle, current.duty, 1}, (next.angle_rate - current.angle_rate) / period);
+        angle_arx.add({current.angle, previous.angle, current.duty, previous.duty}, next.angle);
+    }
+
+    // The speed over (k - D, k] and the average duty and angle over [k - D, k) predict the speed over (k, k + D].
+    for (size_t k = decimation; k + decimation < samples.size(); k += decimation)
+    {
+        if (!contiguous(samples, k - decimation, k + decimation))
+        {
+            continue;
+        }
+
+        double interval = decimation * period * pulses_per_revolution;
+        double speed = (samples[k].position - samples[k - decimation].position) / interval;
+        double next_speed = (samples[k + decimation].position - samples[k].position) / interval;
+        double duty = 0, angle = 0;
+
+        for (size_t i = k - decimation; i < k; i++)
+        {
+            duty += samples[i].duty / decimation;
+            angle += samples[i].angle / decimation;
+        }
+
+        speed_arx.add({speed, duty, angle}, next_speed);
+    }
+
+    try
+    {
+        Fit pendulum_fit = leastSquares(pendulum);
+        Fit angle_fit = leastSquares(angle_arx);
+        Fit speed_fit = leastSquares(speed_arx);
+
+        printf("{\n");
+        printf("  \"sample_period\": %g,\n", period);
+        printf("  \"speed_sample_period\": %g,\n", period * decimation);
+        printf("  \"samples\": %zu,\n", samples.size());
+        printFit("pendulum", {"a", "b", "c"}, pendulum_fit, false);
+        printFit("angle_arx", {"a1", "a2", "b1", "b2"}, angle_fit, false);
+        printFit("speed_arx", {"a1", "b1", "c1"}, speed_fit, true);
+        printf("}\n");
+    }
+    catch (const std::exception &error)
+    {
+        fprintf(stderr, "sysid-fit: %s\n", error.what());
+        return 1;
+    }
+}
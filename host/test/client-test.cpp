@@ -0,0 +1,274 @@
+/// End to end test of the client library and the daemon against the emulator.
+///
+/// Starts balancer-emulator and runs the same scenario over a direct link and through balancerd: pipelined writes
+/// and reads must be matched to their requests, then a request outlasting its timeout while data streams must fail
+/// alone, its late response must be discarded and the next requests must complete. Through the daemon, clients that
+/// close their socket while data streams to them must not take it down.
+///
+///     client-test [build directory]
+
+#include "Client.h"
+#include "Transport.h"
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <string>
+#include <system_error>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+/// [ms] Time the emulator blocks on gyroscope.calibrate.
+static const int CALIBRATION_TIME = 2700;
+
+/// [ms] Timeout of the calibration request, its response comes late but within the quiet time of the resync.
+static const int CALIBRATION_TIMEOUT = CALIBRATION_TIME - 50;
+
+/// [ms] Time allowed to each step of the scenario.
+static const int STEP_TIME = 5000;
+
+static unsigned long failures = 0;
+
+static void fail(const std::string &message)
+{
+    failures++;
+    printf("%s\n", message.c_str());
+}
+
+static std::string statusName(Client::Status status)
+{
+    return status == Client::Status::OK ? "OK" : Client::formatResponse(Client::Response{status, ""});
+}
+
+/// Callback checking a response.
+static Client::Callback expect(const std::string &context, Client::Status status, const std::string &value = "",
+                               Client::Callback next = nullptr)
+{
+    return [=](const Client::Response &response) {
+        if (response.status != status || (status == Client::Status::OK && response.value != value))
+        {
+            fail(context + ": expected " + statusName(status) + " " + value + ", got " + statusName(response.status) +
+                 " " + response.value);
+        }
+
+        if (next) next(response);
+    };
+}
+
+/// Process events until every request has completed or the time is up.
+static void settle(Client &client, const std::string &context)
+{
+    auto deadline = Clock::now() + std::chrono::milliseconds(STEP_TIME);
+
+    while (client.connected() && !client.idle() && Clock::now() < deadline)
+    {
+        client.poll(10);
+    }
+
+    if (!client.idle())
+    {
+        fail(context + ": requests still pending");
+    }
+}
+
+static void runScenario(Client &client, const std::string &link)
+{
+    for (int i = 0; i < 16; i++)
+    {
+        std::string value = std::to_string(i) + ".5";
+        client.set("balance-pid.kp", value, expect(link + " pipelined write " + value, Client::Status::OK, "OK"));
+        client.get("balance-pid.kp", expect(link + " pipelined read " + value, Client::Status::OK, value));
+    }
+
+    client.get("no-such-property", expect(link + " unknown", Client::Status::UNKNOWN));
+    client.set("battery.voltage", "8", expect(link + " read only", Client::Status::DENIED));
+    settle(client, link + " pipelining");
+
+    unsigned long streamed = 0;
+    client.onStream([&streamed](const std::string &) { streamed++; });
+    client.set("stream.rate", "50", expect(link + " stream start", Client::Status::OK, "OK"));
+    settle(client, link + " stream start");
+
+    auto end = Clock::now() + std::chrono::milliseconds(500);
+
+    while (client.connected() && Clock::now() < end)
+    {
+        client.poll(10);
+    }
+
+    if (streamed < 5)
+    {
+        fail(link + ": " + std::to_string(streamed) + " streamed lines in 500 ms");
+    }
+
+    // The requests queued once the calibration has failed are sent after the resync, while data keeps streaming.
+    client.set("gyroscope.calibrate", "1",
+               expect(link + " calibration", Client::Status::TIMEOUT, "", [&client, link](const Client::Response &) {
+                   client.get("battery.voltage", expect(link + " read after timeout", Client::Status::OK, "7.40"));
+                   client.set("stream.rate", "0", expect(link + " stream stop", Client::Status::OK, "OK"));
+               }),
+               CALIBRATION_TIMEOUT);
+
+    settle(client, link + " timeout and resync");
+}
+
+static pid_t spawn(const std::vector<std::string> &arguments)
+{
+    pid_t pid = fork();
+
+    if (pid == 0)
+    {
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDOUT_FILENO);
+
+        std::vector<char *> argv;
+
+        for (const std::string &argument : arguments)
+        {
+            argv.push_back(const_cast<char *>(argument.c_str()));
+        }
+
+        argv.push_back(nullptr);
+        execv(argv[0], argv.data());
+        perror(argv[0]);
+        _exit(127);
+    }
+
+    return pid;
+}
+
+static bool waitForPath(const std::string &path)
+{
+    auto deadline = Clock::now() + std::chrono::milliseconds(STEP_TIME);
+    struct stat status;
+
+    while (stat(path.c_str(), &status) != 0)
+    {
+        if (Clock::now() >= deadline)
+        {
+            fail("timed out waiting for " + path);
+            return false;
+        }
+
+        usleep(10000);
+    }
+
+    return true;
+}
+
+/// Connect to the daemon once it listens.
+static int connectDaemon(const std::string &path)
+{
+    auto deadline = Clock::now() + std::chrono::milliseconds(STEP_TIME);
+
+    for (;;)
+    {
+        try
+        {
+            return connectSocket(path);
+        }
+        catch (const std::system_error &)
+        {
+            if (Clock::now() >= deadline) throw;
+        }
+
+        usleep(10000);
+    }
+}
+
+/// Connect clients that close their socket abruptly while a fast stream is fanned out to them.
+static void runDisconnects(Client &client, const std::string &path)
+{
+    client.set("stream.rate", "1000", expect("disconnect stream start", Client::Status::OK, "OK"));
+    settle(client, "disconnect stream start");
+
+    for (int i = 0; i < 50; i++)
+    {
+        int fd;
+
+        try
+        {
+            fd = connectSocket(path);
+        }
+        catch (const std::system_error &)
+        {
+            fail("disconnect: the daemon refused client " + std::to_string(i));
+            return;
+        }
+
+        const char request[] = "battery.voltage\n";
+
+        if (write(fd, request, sizeof(request) - 1) < 0)
+        {
+            fail("disconnect: write failed");
+        }
+
+        client.poll(i % 5);
+        close(fd);
+        client.poll(0);
+    }
+
+    client.get("battery.voltage", expect("read after disconnects", Client::Status::OK, "7.40"));
+    client.set("stream.rate", "0", expect("disconnect stream stop", Client::Status::OK, "OK"));
+    settle(client, "disconnects");
+}
+
+static void stop(pid_t pid)
+{
+    kill(pid, SIGTERM);
+    waitpid(pid, nullptr, 0);
+}
+
+int main(int argc, char **argv)
+{
+    std::string build = argc > 1 ? argv[1] : "build";
+    char directory[] = "/tmp/client-test-XXXXXX";
+
+    if (mkdtemp(directory) == nullptr)
+    {
+        perror("client-test: mkdtemp");
+        return 1;
+    }
+
+    std::string link = std::string(directory) + "/tty";
+    std::string socket = std::string(directory) + "/socket";
+
+    pid_t emulator = spawn({build + "/balancer-emulator", "-l", link});
+    pid_t daemon = -1;
+
+    try
+    {
+        if (waitForPath(link))
+        {
+            Client client(openSerialPort(link, 9600));
+            runScenario(client, "serial");
+        }
+
+        daemon = spawn({build + "/balancerd", "-t", std::to_string(CALIBRATION_TIMEOUT), link, socket});
+
+        // The daemon reports its own timeouts, the client waits for them.
+        Client client(connectDaemon(socket), Client::DAEMON_WINDOW, 2 * STEP_TIME);
+        runScenario(client, "daemon");
+        runDisconnects(client, socket);
+    }
+    catch (const std::exception &error)
+    {
+        fail(std::string("client-test: ") + error.what());
+    }
+
+    if (daemon > 0) stop(daemon);
+    stop(emulator);
+
+    unlink(link.c_str());
+    unlink(socket.c_str());
+    rmdir(directory);
+
+    printf("%lu failures\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+/// Round trip test of the firmware's decimal conversions, built from src/convert.cpp.
+///
+/// Formats and parses back every decimal of up to six significant digits at each precision used by the properties,
+/// which float always represents closely enough to print back unchanged. Parsed values are compared to the
+/// correctly rounded strtof, down to the subnormals, and malformed input must give NaN.
+///
+///     convert-test
+
+#include "convert.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+static unsigned long failures = 0;
+
+static void fail(const char *format, const std::string &input, double value)
+{
+    if (failures++ < 20)
+    {
+        printf(format, input.c_str(), value);
+        printf("\n");
+    }
+}
+
+/// [ulp] Distance between two floats.
+static long ulpDistance(float a, float b)
+{
+    int32_t ia, ib;
+    memcpy(&ia, &a, sizeof(ia));
+    memcpy(&ib, &b, sizeof(ib));
+
+    // Map the sign magnitude representation to a monotonic integer scale.
+    long la = ia < 0 ? INT32_MIN - static_cast<long>(ia) : ia;
+    long lb = ib < 0 ? INT32_MIN - static_cast<long>(ib) : ib;
+    return std::labs(la - lb);
+}
+
+static void checkParse(const std::string &input, long max_ulp)
+{
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "%s", input.c_str());
+
+    // The firmware computes in float, double is float on the AVR.
+    float parsed = stringToDouble(buffer);
+    float expected = strtof(input.c_str(), nullptr);
+
+    if (std::isnan(parsed) || ulpDistance(parsed, expected) > max_ulp)
+    {
+        fail("parse %s: %.9g", input, parsed);
+    }
+}
+
+/// Format then parse back every decimal n / 10^precision with |n| < 10^6.
+static void checkRoundTrip(uint8_t precision)
+{
+    const long limit = 1000000;
+    long scale = std::lround(std::pow(10, precision));
+
+    for (long n = -limit + 1; n < limit; n++)
+    {
+        long magnitude = std::labs(n);
+        std::string text = (n < 0 ? "-" : "") + std::to_string(magnitude / scale);
+
+        if (precision > 0)
+        {
+            std::string fraction = std::to_string(magnitude % scale);
+            text += "." + std::string(precision - fraction.size(), '0') + fraction;
+        }
+
+        char input[32], output[32];
+        strcpy(input, text.c_str());
+        float parsed = stringToDouble(input);
+        doubleToString(parsed, precision, output);
+
+        // Zero keeps its sign through the conversions.
+        if (text != output && !(n == 0 && text == output + (output[0] == '-')))
+        {
+            fail("round trip %s: %.9g", text, parsed);
+        }
+
+        checkParse(text, 1);
+    }
+}
+
+static void checkMalformed(const char *input)
+{
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "%s", input);
+
+    if (!std::isnan(stringToDouble(buffer)))
+    {
+        fail("malformed %s: %.9g", input, stringToDouble(buffer));
+    }
+}
+
+int main()
+{
+    static const uint8_t PRECISIONS[] = {0, 1, 2, 3, 4, 8};
+
+    for (uint8_t precision : PRECISIONS)
+    {
+        checkRoundTrip(precision);
+    }
+
+    // Every power of ten, through the subnormals, where the spacing of floats is absolute.
+    for (int exponent = 1; exponent <= 50; exponent++)
+    {
+        std::string small = "0." + std::string(exponent - 1, '0') + "1";
+        checkParse(small, 2);
+        checkParse("-" + small + "25", 2);
+    }
+
+    for (int exponent = 0; exponent <= 38; exponent++)
+    {
+        checkParse("1" + std::string(exponent, '0'), 2);
+        checkParse("34" + std::string(exponent > 0 ? exponent - 1 : 0, '0'), 2);
+    }
+
+    // Digits beyond the mantissa precision are dropped.
+    checkParse("123456789012345678901234567890", 2);
+    checkParse("0.000012345678901234567890", 2);
+    checkParse("  +42.5  ", 1);
+
+    // The last one overflows float.
+    static const char *MALFORMED[] = {"",   " ",   "-",   "+",   ".",   "-.",  "1.2.3",
+                                      "1x", "x1",  "1 2", "1e5", "--1", "4000000000000000000000000000000000000000"};
+
+    for (const char *input : MALFORMED)
+    {
+        checkMalformed(input);
+    }
+
+    char buffer[16];
+
+    if (strcmp(doubleToString(NAN, 2, buffer), "nan") != 0 || strcmp(doubleToString(5e9, 2, buffer), "ovf") != 0)
+    {
+        fail("special %s: %.9g", buffer, 0.0);
+    }
+
+    printf("%lu failures\n", failures);
+    return failures == 0 ? 0 : 1;
+}
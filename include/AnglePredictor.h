@@ -0,0 +1,44 @@
+/// Latency compensating inclination predictor.
+
+#ifndef _ANGLE_PREDICTOR_H_
+#define _ANGLE_PREDICTOR_H_
+
+class AnglePredictor
+{
+  public:
+    AnglePredictor(float horizon, float duty_gain);
+
+    /// Extrapolate the inclination to the expected actuation time from its rate of change and the applied duty.
+    float predict(float angle, float angle_rate, float duty);
+
+    /// [ms] Get the prediction horizon.
+    inline float getHorizon()
+    {
+        return horizon_ * 1000.0;
+    }
+
+    /// [ms] Set the prediction horizon, zero disables the prediction.
+    inline void setHorizon(float horizon)
+    {
+        horizon_ = horizon / 1000.0;
+    }
+
+    /// [rad/s^2] Get the angular acceleration produced by a unit of duty.
+    inline float getDutyGain()
+    {
+        return duty_gain_;
+    }
+
+    /// [rad/s^2] Set the angular acceleration produced by a unit of duty.
+    inline void setDutyGain(float duty_gain)
+    {
+        duty_gain_ = duty_gain;
+    }
+
+  private:
+    /// [s]
+    float horizon_;
+    float duty_gain_;
+};
+
+#endif // _ANGLE_PREDICTOR_H_
@@ -0,0 +1,51 @@
+/// Battery voltage sensing through interrupt driven ADC conversions.
+
+#ifndef _BATTERY_MONITOR_H_
+#define _BATTERY_MONITOR_H_
+
+#include "configuration.h"
+#include <stdint.h>
+
+class BatteryMonitor
+{
+  public:
+    BatteryMonitor(uint8_t pin, float divider_ratio);
+
+    /// Start the automatic conversions, the ADC is then reserved and analogRead() must not be used.
+    void begin();
+
+    /// [V] Get the battery voltage averaged over the last block of conversions.
+    float getVoltage();
+
+    /// Get the ratio between the nominal and the actual battery voltage, 1 if the battery is not connected.
+    float getCompensation();
+
+    /// Private method.
+    inline void _onConversion(uint16_t sample)
+    {
+        accumulator_ += sample;
+
+        if (++sample_count_ == SAMPLE_COUNT)
+        {
+            sum_ = accumulator_;
+            accumulator_ = 0;
+            sample_count_ = 0;
+        }
+    }
+
+  private:
+    /// Number of conversions averaged in each reading, the sum must fit 16 bits.
+    static const uint8_t SAMPLE_COUNT = 64;
+
+    /// [V] Reference voltage of the ADC.
+    static const constexpr float REFERENCE_VOLTAGE = 5.0;
+
+    uint8_t pin_;
+    float scale_;
+
+    uint16_t accumulator_ = 0;
+    uint8_t sample_count_ = 0;
+    volatile uint16_t sum_ = 0;
+};
+
+#endif // _BATTERY_MONITOR_H_
@@ -0,0 +1,72 @@
+/// Fixed point biquad filter cascade.
+
+#ifndef _BIQUAD_FILTER_H_
+#define _BIQUAD_FILTER_H_
+
+#include "configuration.h"
+#include <stdint.h>
+
+class BiquadFilter
+{
+  public:
+    /// Section coefficients in Q2.14, normalized so that a0 is 1.
+    struct Section
+    {
+        int16_t b0, b1, b2, a1, a2;
+    };
+
+    /// Coefficients of a section that passes its input through.
+    static constexpr Section IDENTITY = Section{1 << 14, 0, 0, 0, 0};
+
+    /// Fixed point coefficient representing 1.
+    static constexpr float COEFFICIENT_ONE = 1 << 14;
+
+    /// The scale converts the signal to fixed point, its range is limited to +-8192 / scale.
+    BiquadFilter(float scale);
+
+    /// Filter the next sample, all the sections pass the input through unchanged by default.
+    float process(float input);
+
+    /// Get the last filtered sample.
+    inline float getOutput()
+    {
+        return output_;
+    }
+
+    inline const Section &getSection(uint8_t index)
+    {
+        return sections_[index];
+    }
+
+    /// Check whether the poles of a section lie inside the unit circle, within the stability triangle
+    /// |a2| < 1, |a1| < 1 + a2.
+    static inline bool isStable(const Section &section)
+    {
+        const int32_t one = COEFFICIENT_ONE;
+        return section.a2 > -one && section.a2 < one && section.a1 < one + section.a2 && -section.a1 < one + section.a2;
+    }
+
+    /// Replace the coefficients of a section and clear the filter history.
+    void setSection(uint8_t index, const Section &section);
+
+  private:
+    /// Samples are limited so that the five products of a section cannot overflow the accumulator.
+    static const int16_t SAMPLE_LIMIT = 8192;
+
+    struct State
+    {
+        int16_t x1, x2, y1, y2;
+    };
+
+    float scale_;
+    float output_ = 0;
+
+    Section sections_[BIQUAD_SECTIONS];
+    State states_[BIQUAD_SECTIONS];
+    bool active_[BIQUAD_SECTIONS];
+    uint8_t active_count_ = 0;
+
+    static int16_t saturate(int32_t value);
+};
+
+#endif // _BIQUAD_FILTER_H_
@@ -31,6 +31,9 @@
  *          >>> test_property=20=200
  *          <<< MALFORMED
  *
+ *      Streamed data, sent without a request:
+ *          <<< #123,-45,210
+ *
  */
 
 #ifndef _COMMUNICATION_MANAGER_H_
@@ -49,6 +52,7 @@ struct Handler
     /// Return true if an error occured during the operation.
     typedef bool (*Setter)(char *buffer);
 
+    /// Property name, stored in program memory.
     const char *name;
     Getter get;
     Setter set;
@@ -68,7 +72,26 @@ class CommunicationManager
         handlers_size_ = LEN;
     }
 
-    void tick();
+    /// Process the incoming packets until the stream is empty or the time budget [us] runs out, at least one unless
+    /// the budget is zero. A packet that is ready once the budget has run out, or while the output stream has no room
+    /// for its response, is deferred to the next call.
+    void tick(uint32_t budget = UINT32_MAX);
+
+    /// Get the number of packets deferred because the time budget had run out or the output stream was full.
+    inline uint32_t getDeferredPackets()
+    {
+        return deferred_packets_;
+    }
+
+    /// Get the number of streamed lines dropped because the output stream was full.
+    inline uint32_t getDroppedPackets()
+    {
+        return dropped_packets_;
+    }
+
+    /// Push a line of streamed data, it is prefixed with STREAM_PREFIX and dropped if the output stream is full or
+    /// lacks the room kept for the response of a deferred packet.
+    void stream(const char *data);
 
   private:
     /// Maximum length of a packet in bytes.
@@ -80,6 +103,9 @@ class CommunicationManager
     /// Character used to mark end of the property name and the start of the packet payload.
     static const char PAYLOAD_DELIMITER = '=';
 
+    /// Character marking the lines of streamed data, which are not responses to a request.
+    static const char STREAM_PREFIX = '#';
+
     /// Response used when setting the property was successful.
     static constexpr const char *RESPONSE_OK = "OK";
 
@@ -108,6 +134,12 @@ class CommunicationManager
     char serial_buffer_[PACKET_SIZE];
     size_t serial_buffer_size_ = 0;
 
+    uint32_t dropped_packets_ = 0;
+    uint32_t deferred_packets_ = 0;
+
+    /// Whether the packet in the serial buffer has already been counted as deferred.
+    bool packet_deferred_ = false;
+
     /// Store the next incoming packet into the serial buffer.
     /// Returns true if a packet is currently stored in the buffer.
     bool fillBuffer();
@@ -124,6 +156,8 @@ class CommunicationManager
     Handler *findProperty(char *search);
 
     /// Push a packet to the output stream.
+    /// tick() only handles a packet once the stream's output buffer has room for its response, so that writing it
+    /// never blocks.
     void writePacket(const char *data);
 
     void handleRequest(Packet *packet);
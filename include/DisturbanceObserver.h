@@ -0,0 +1,92 @@
+/// Lumped external torque estimator on the inclination dynamics.
+
+#ifndef _DISTURBANCE_OBSERVER_H_
+#define _DISTURBANCE_OBSERVER_H_
+
+#include <stdint.h>
+
+class DisturbanceObserver
+{
+  public:
+    DisturbanceObserver(float bandwidth, float stiffness, float duty_gain, float max_compensation);
+
+    /// Update the estimate from the inclination, its rate and the duty applied since the previous update.
+    /// Returns the duty that cancels the estimated disturbance.
+    float update(float angle, float angle_rate, float duty);
+
+    /// Forget the estimate, the next update only takes its rate as a reference.
+    void reset();
+
+    /// [rad/s^2] Get the angular acceleration not explained by the inclination and the duty.
+    inline float getDisturbance()
+    {
+        return disturbance_;
+    }
+
+    /// Get the duty that cancels the estimated disturbance.
+    float getCompensation();
+
+    inline bool isEnabled()
+    {
+        return enabled_;
+    }
+
+    /// Enable the observer, a disabled observer forgets its estimate and compensates nothing.
+    inline void setEnabled(bool enabled)
+    {
+        enabled_ = enabled;
+        if (!enabled) reset();
+    }
+
+    /// [Hz] Get the cut-off frequency of the estimate.
+    inline float getBandwidth()
+    {
+        return bandwidth_;
+    }
+
+    /// [Hz] Set the cut-off frequency of the estimate.
+    inline void setBandwidth(float bandwidth)
+    {
+        bandwidth_ = bandwidth;
+    }
+
+    /// [1/s^2] Get the angular acceleration produced by a unit of inclination.
+    inline float getStiffness()
+    {
+        return stiffness_;
+    }
+
+    /// [1/s^2] Set the angular acceleration produced by a unit of inclination.
+    inline void setStiffness(float stiffness)
+    {
+        stiffness_ = stiffness;
+    }
+
+    /// [rad/s^2] Get the angular acceleration produced by a unit of duty.
+    inline float getDutyGain()
+    {
+        return duty_gain_;
+    }
+
+    /// [rad/s^2] Set the angular acceleration produced by a unit of duty, zero disables the compensation.
+    inline void setDutyGain(float duty_gain)
+    {
+        duty_gain_ = duty_gain;
+    }
+
+  private:
+    /// [us] Longest interval between updates that is still differentiated.
+    static const uint32_t MAX_UPDATE_INTERVAL = 100000;
+
+    bool enabled_ = false;
+    float bandwidth_, stiffness_, duty_gain_, max_compensation_;
+
+    bool primed_ = false;
+    uint32_t last_update_;
+    float last_angle_rate_;
+
+    /// [rad/s^2]
+    float disturbance_ = 0;
+};
+
+#endif // _DISTURBANCE_OBSERVER_H_
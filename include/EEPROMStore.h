@@ -3,6 +3,9 @@
 #ifndef _EEPROM_STORE_H_
 #define _EEPROM_STORE_H_
 
+#include "BiquadFilter.h"
+#include "GainScheduler.h"
+#include "Gyroscope.h"
 #include <EEPROM.h>
 #include <inttypes.h>
 #include <stddef.h>
@@ -24,85 +27,352 @@ class EEPROMStore
         EEPROM.put(Address::GyroZeroAngle, zero_angle);
     };
 
-    inline float getBalancePIDkP()
+    inline Gyroscope::Offset getGyroOffsetAccel()
+    {
+        Gyroscope::Offset offset;
+        return EEPROM.get(Address::GyroOffsetAccel, offset);
+    };
+
+    inline void setGyroOffsetAccel(const Gyroscope::Offset &offset)
+    {
+        EEPROM.put(Address::GyroOffsetAccel, offset);
+    };
+
+    inline Gyroscope::Offset getGyroOffsetGyro()
+    {
+        Gyroscope::Offset offset;
+        return EEPROM.get(Address::GyroOffsetGyro, offset);
+    };
+
+    inline void setGyroOffsetGyro(const Gyroscope::Offset &offset)
+    {
+        EEPROM.put(Address::GyroOffsetGyro, offset);
+    };
+
+    inline BiquadFilter::Section getBiquadSection(uint8_t filter, uint8_t index)
+    {
+        BiquadFilter::Section section;
+        return EEPROM.get(Address::BiquadSections + (filter * BIQUAD_SECTIONS + index) * sizeof(section), section);
+    };
+
+    inline void setBiquadSection(uint8_t filter, uint8_t index, const BiquadFilter::Section &section)
+    {
+        EEPROM.put(Address::BiquadSections + (filter * BIQUAD_SECTIONS + index) * sizeof(section), section);
+    };
+
+    inline bool getBalancePIDDOnRate()
+    {
+        bool d_on_rate;
+        return EEPROM.get(Address::BalancePIDDOnRate, d_on_rate);
+    };
+
+    inline void setBalancePIDDOnRate(bool d_on_rate)
+    {
+        EEPROM.put(Address::BalancePIDDOnRate, d_on_rate);
+    };
+
+    inline float getAnglePredictorHorizon()
+    {
+        float horizon;
+        return EEPROM.get(Address::AnglePredictorHorizon, horizon);
+    };
+
+    inline void setAnglePredictorHorizon(float horizon)
+    {
+        EEPROM.put(Address::AnglePredictorHorizon, horizon);
+    };
+
+    inline float getAnglePredictorDutyGain()
+    {
+        float duty_gain;
+        return EEPROM.get(Address::AnglePredictorDutyGain, duty_gain);
+    };
+
+    inline void setAnglePredictorDutyGain(float duty_gain)
+    {
+        EEPROM.put(Address::AnglePredictorDutyGain, duty_gain);
+    };
+
+    inline bool getBatteryCompensation()
+    {
+        bool compensation;
+        return EEPROM.get(Address::BatteryCompensation, compensation);
+    };
+
+    inline void setBatteryCompensation(bool compensation)
+    {
+        EEPROM.put(Address::BatteryCompensation, compensation);
+    };
+
+    inline GainProfile getGainProfile(uint8_t index)
+    {
+        GainProfile profile;
+        return EEPROM.get(Address::GainProfiles + index * sizeof(GainProfile), profile);
+    };
+
+    inline void setGainProfile(uint8_t index, const GainProfile &profile)
+    {
+        EEPROM.put(Address::GainProfiles + index * sizeof(GainProfile), profile);
+    };
+
+    inline uint8_t getGainProfileIndex()
+    {
+        uint8_t index;
+        return EEPROM.get(Address::GainProfileIndex, index);
+    };
+
+    inline void setGainProfileIndex(uint8_t index)
+    {
+        EEPROM.put(Address::GainProfileIndex, index);
+    };
+
+    inline GainScheduler::Source getGainScheduleSource()
+    {
+        GainScheduler::Source source;
+        return EEPROM.get(Address::GainScheduleSource, source);
+    };
+
+    inline void setGainScheduleSource(GainScheduler::Source source)
+    {
+        EEPROM.put(Address::GainScheduleSource, source);
+    };
+
+    inline uint16_t getBalancePIDSamplePeriod()
+    {
+        uint16_t sample_period;
+        return EEPROM.get(Address::BalancePIDSamplePeriod, sample_period);
+    };
+
+    inline void setBalancePIDSamplePeriod(uint16_t sample_period)
+    {
+        EEPROM.put(Address::BalancePIDSamplePeriod, sample_period);
+    };
+
+    inline uint16_t getVelocityPIDSamplePeriod()
+    {
+        uint16_t sample_period;
+        return EEPROM.get(Address::VelocityPIDSamplePeriod, sample_period);
+    };
+
+    inline void setVelocityPIDSamplePeriod(uint16_t sample_period)
+    {
+        EEPROM.put(Address::VelocityPIDSamplePeriod, sample_period);
+    };
+
+    inline float getPositionPIDkP()
     {
         float kp;
-        return EEPROM.get(Address::BalancePIDkP, kp);
+        return EEPROM.get(Address::PositionPIDkP, kp);
     };
 
-    inline void setBalancePIDkP(float kp)
+    inline void setPositionPIDkP(float kp)
     {
-        EEPROM.put(Address::BalancePIDkP, kp);
+        EEPROM.put(Address::PositionPIDkP, kp);
     };
 
-    inline float getBalancePIDkI()
+    inline float getPositionPIDkI()
     {
         float ki;
-        return EEPROM.get(Address::BalancePIDkI, ki);
+        return EEPROM.get(Address::PositionPIDkI, ki);
     };
 
-    inline void setBalancePIDkI(float ki)
+    inline void setPositionPIDkI(float ki)
     {
-        EEPROM.put(Address::BalancePIDkI, ki);
+        EEPROM.put(Address::PositionPIDkI, ki);
     };
 
-    inline float getBalancePIDkD()
+    inline float getPositionPIDkD()
     {
         float kd;
-        return EEPROM.get(Address::BalancePIDkD, kd);
+        return EEPROM.get(Address::PositionPIDkD, kd);
+    };
+
+    inline void setPositionPIDkD(float kd)
+    {
+        EEPROM.put(Address::PositionPIDkD, kd);
+    };
+
+    inline float getMotionMaxAcceleration()
+    {
+        float max_acceleration;
+        return EEPROM.get(Address::MotionMaxAcceleration, max_acceleration);
+    };
+
+    inline void setMotionMaxAcceleration(float max_acceleration)
+    {
+        EEPROM.put(Address::MotionMaxAcceleration, max_acceleration);
+    };
+
+    inline float getMotionMaxJerk()
+    {
+        float max_jerk;
+        return EEPROM.get(Address::MotionMaxJerk, max_jerk);
     };
 
-    inline void setBalancePIDkD(float kd)
+    inline void setMotionMaxJerk(float max_jerk)
     {
-        EEPROM.put(Address::BalancePIDkD, kd);
+        EEPROM.put(Address::MotionMaxJerk, max_jerk);
     };
 
-    inline float getVelocityPIDkP()
+    inline bool getMotionFeedforward()
+    {
+        bool feedforward;
+        return EEPROM.get(Address::MotionFeedforward, feedforward);
+    };
+
+    inline void setMotionFeedforward(bool feedforward)
+    {
+        EEPROM.put(Address::MotionFeedforward, feedforward);
+    };
+
+    inline bool getObserverEnabled()
+    {
+        bool enabled;
+        return EEPROM.get(Address::ObserverEnabled, enabled);
+    };
+
+    inline void setObserverEnabled(bool enabled)
+    {
+        EEPROM.put(Address::ObserverEnabled, enabled);
+    };
+
+    inline float getObserverBandwidth()
+    {
+        float bandwidth;
+        return EEPROM.get(Address::ObserverBandwidth, bandwidth);
+    };
+
+    inline void setObserverBandwidth(float bandwidth)
+    {
+        EEPROM.put(Address::ObserverBandwidth, bandwidth);
+    };
+
+    inline float getObserverStiffness()
+    {
+        float stiffness;
+        return EEPROM.get(Address::ObserverStiffness, stiffness);
+    };
+
+    inline void setObserverStiffness(float stiffness)
+    {
+        EEPROM.put(Address::ObserverStiffness, stiffness);
+    };
+
+    inline float getObserverDutyGain()
+    {
+        float duty_gain;
+        return EEPROM.get(Address::ObserverDutyGain, duty_gain);
+    };
+
+    inline void setObserverDutyGain(float duty_gain)
+    {
+        EEPROM.put(Address::ObserverDutyGain, duty_gain);
+    };
+
+    inline bool getVelocityObserverEnabled()
+    {
+        bool enabled;
+        return EEPROM.get(Address::VelocityObserverEnabled, enabled);
+    };
+
+    inline void setVelocityObserverEnabled(bool enabled)
+    {
+        EEPROM.put(Address::VelocityObserverEnabled, enabled);
+    };
+
+    inline bool getIdleEnabled()
+    {
+        bool enabled;
+        return EEPROM.get(Address::IdleEnabled, enabled);
+    };
+
+    inline void setIdleEnabled(bool enabled)
+    {
+        EEPROM.put(Address::IdleEnabled, enabled);
+    };
+
+    inline float getWheelPIDkP()
     {
         float kp;
-        return EEPROM.get(Address::VelocityPIDkP, kp);
+        return EEPROM.get(Address::WheelPIDkP, kp);
     };
 
-    inline void setVelocityPIDkP(float kp)
+    inline void setWheelPIDkP(float kp)
     {
-        EEPROM.put(Address::VelocityPIDkP, kp);
+        EEPROM.put(Address::WheelPIDkP, kp);
     };
 
-    inline float getVelocityPIDkI()
+    inline float getWheelPIDkI()
     {
         float ki;
-        return EEPROM.get(Address::VelocityPIDkI, ki);
+        return EEPROM.get(Address::WheelPIDkI, ki);
     };
 
-    inline void setVelocityPIDkI(float ki)
+    inline void setWheelPIDkI(float ki)
     {
-        EEPROM.put(Address::VelocityPIDkI, ki);
+        EEPROM.put(Address::WheelPIDkI, ki);
     };
 
-    inline float getVelocityPIDkD()
+    inline float getMotorTrimLeft()
     {
-        float kd;
-        return EEPROM.get(Address::VelocityPIDkD, kd);
+        float trim;
+        return EEPROM.get(Address::MotorTrimLeft, trim);
+    };
+
+    inline void setMotorTrimLeft(float trim)
+    {
+        EEPROM.put(Address::MotorTrimLeft, trim);
     };
 
-    inline void setVelocityPIDkD(float kd)
+    inline float getMotorTrimRight()
     {
-        EEPROM.put(Address::VelocityPIDkD, kd);
+        float trim;
+        return EEPROM.get(Address::MotorTrimRight, trim);
     };
 
+    inline void setMotorTrimRight(float trim)
+    {
+        EEPROM.put(Address::MotorTrimRight, trim);
+    };
+
+    /// Number of filters with stored sections.
+    static const uint8_t BIQUAD_FILTER_COUNT = 3;
+
   private:
-    const size_t VERSION = 12;
+    const size_t VERSION = 25;
 
     enum Address : int32_t
     {
         Version = sizeof(size_t),
         GyroZeroAngle = Version + sizeof(float),
-        BalancePIDkP = GyroZeroAngle + sizeof(float),
-        BalancePIDkI = BalancePIDkP + sizeof(float),
-        BalancePIDkD = BalancePIDkI + sizeof(float),
-        VelocityPIDkP = BalancePIDkD + sizeof(float),
-        VelocityPIDkI = VelocityPIDkP + sizeof(float),
-        VelocityPIDkD = VelocityPIDkI + sizeof(float),
+        BalancePIDDOnRate = GyroZeroAngle + sizeof(float),
+        AnglePredictorHorizon = BalancePIDDOnRate + sizeof(bool),
+        AnglePredictorDutyGain = AnglePredictorHorizon + sizeof(float),
+        PositionPIDkP = AnglePredictorDutyGain + sizeof(float),
+        PositionPIDkI = PositionPIDkP + sizeof(float),
+        PositionPIDkD = PositionPIDkI + sizeof(float),
+        GainProfileIndex = PositionPIDkD + sizeof(float),
+        GainScheduleSource = GainProfileIndex + sizeof(uint8_t),
+        BatteryCompensation = GainScheduleSource + sizeof(GainScheduler::Source),
+        GyroOffsetAccel = BatteryCompensation + sizeof(bool),
+        GyroOffsetGyro = GyroOffsetAccel + sizeof(Gyroscope::Offset),
+        BalancePIDSamplePeriod = GyroOffsetGyro + sizeof(Gyroscope::Offset),
+        VelocityPIDSamplePeriod = BalancePIDSamplePeriod + sizeof(uint16_t),
+        WheelPIDkP = VelocityPIDSamplePeriod + sizeof(uint16_t),
+        WheelPIDkI = WheelPIDkP + sizeof(float),
+        MotorTrimLeft = WheelPIDkI + sizeof(float),
+        MotorTrimRight = MotorTrimLeft + sizeof(float),
+        MotionMaxAcceleration = MotorTrimRight + sizeof(float),
+        MotionMaxJerk = MotionMaxAcceleration + sizeof(float),
+        MotionFeedforward = MotionMaxJerk + sizeof(float),
+        IdleEnabled = MotionFeedforward + sizeof(bool),
+        ObserverEnabled = IdleEnabled + sizeof(bool),
+        ObserverBandwidth = ObserverEnabled + sizeof(bool),
+        ObserverStiffness = ObserverBandwidth + sizeof(float),
+        ObserverDutyGain = ObserverStiffness + sizeof(float),
+        VelocityObserverEnabled = ObserverDutyGain + sizeof(float),
+        BiquadSections = VelocityObserverEnabled + sizeof(bool),
+        GainProfiles = BiquadSections + BIQUAD_FILTER_COUNT * BIQUAD_SECTIONS * sizeof(BiquadFilter::Section),
     };
 };
 
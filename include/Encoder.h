@@ -3,7 +3,9 @@
 #ifndef _ENCODER_H_
 #define _ENCODER_H_
 
+#include "InterruptProfiler.h"
 #include "configuration.h"
+#include <Arduino.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -12,17 +14,38 @@ class Encoder
   public:
     Encoder(float sample_time, uint8_t pin_phase_a, uint8_t pin_phase_b, uint8_t fw_level);
 
+#ifndef ENCODER_DIRECT_ISR
     /// Set up the hardware peripherals and enable the interrupt handler.
     void begin();
+#endif
 
     /// Perform the calculations necessary to update the frequency value.
     bool tick();
 
+    /// [ms] Set the period over which the frequency is measured.
+    inline void setSampleTime(float sample_time)
+    {
+        sample_time_ = sample_time;
+    }
+
     /// Get the last measured frequency.
     float getFrequency();
 
+    /// Get the number of pulses counted since startup, negative when going backwards.
+    int32_t getPosition();
+
+#ifdef INTERRUPT_PROFILER
+    /// Get the number of pulses that were probably missed, detected from sudden jumps in the gap between pulses.
+    uint32_t getMissedPulses();
+#endif
+
     /// Private method.
-    inline void _onPulse();
+    void _onPulse();
+
+  protected:
+    /// Count a pulse, reverse when phase B is not at the forward level, common to the generic and direct interrupt
+    /// handlers. Reverse pulses count as clockwise, towards positive speeds and positions.
+    inline void countPulse(bool reverse);
 
   private:
     /// Length of the pulse buffer.
@@ -41,10 +64,108 @@ class Encoder
     uint8_t pin_phase_a_, pin_phase_b_, fw_level_;
     uint8_t port_phase_b_, bit_phase_b_;
 
-    uint32_t pulse_count_;
-    Direction direction_;
+    volatile uint32_t pulse_count_;
+    volatile Direction direction_;
+    volatile int32_t position_ = 0;
+
+#ifdef INTERRUPT_PROFILER
+    uint32_t last_pulse_ = 0, last_gap_ = UINT32_MAX;
+    volatile uint32_t missed_pulses_ = 0;
+#endif
 
     float frequency_;
 };
 
+void Encoder::countPulse(bool reverse)
+{
+    Direction next_direction = reverse ? Direction::CW : Direction::CCW;
+
+    if (next_direction == direction_)
+    {
+        pulse_count_++;
+    }
+    else
+    {
+        pulse_count_ = 1;
+    }
+
+#ifdef INTERRUPT_PROFILER
+    uint32_t now = micros();
+    uint32_t gap = now - last_pulse_;
+
+    // At steady speed a missed pulse shows up as a gap about twice as long as the previous one.
+    if (next_direction == direction_ && last_gap_ < ENCODER_MISSED_PULSE_MAX_GAP && gap > last_gap_ + last_gap_ / 2)
+    {
+        missed_pulses_++;
+    }
+
+    last_pulse_ = now;
+    last_gap_ = gap;
+#endif
+
+    direction_ = next_direction;
+    position_ += next_direction == Direction::CW ? 1 : -1;
+}
+
+#ifdef ENCODER_DIRECT_ISR
+/// Encoder bound at compile time to the external interrupt of its phase A pin.
+///
+/// The owner defines ISR(INT0_vect) or ISR(INT1_vect), according to INTERRUPT, and calls _onInterrupt from it.
+template <uint8_t PIN_PHASE_A, uint8_t PIN_PHASE_B, uint8_t FW_LEVEL> class DirectEncoder : public Encoder
+{
+    static_assert(PIN_PHASE_A == 2 || PIN_PHASE_A == 3, "Phase A must be on an external interrupt pin.");
+    static_assert(PIN_PHASE_B < 20, "Phase B must be on a digital or analog pin.");
+
+  public:
+    /// External interrupt number of the phase A pin.
+    static const uint8_t INTERRUPT = PIN_PHASE_A - 2;
+
+    DirectEncoder(float sample_time) : Encoder(sample_time, PIN_PHASE_A, PIN_PHASE_B, FW_LEVEL)
+    {
+    }
+
+    /// Set up the hardware peripherals and enable the interrupt handler.
+    void begin()
+    {
+        pinMode(PIN_PHASE_A, INPUT_PULLUP);
+        pinMode(PIN_PHASE_B, INPUT_PULLUP);
+
+        // Trigger on the rising edge, clear any stale request, then enable the interrupt.
+        EICRA |= (1 << ISC00 | 1 << ISC01) << (2 * INTERRUPT);
+        EIFR = 1 << (INTF0 + INTERRUPT);
+        EIMSK |= 1 << (INT0 + INTERRUPT);
+    }
+
+    /// Private method.
+    inline void _onInterrupt()
+    {
+#ifdef INTERRUPT_PROFILER
+        uint8_t start = InterruptProfiler::enter();
+        countPulse(readPhaseB() != FW_LEVEL);
+        InterruptProfiler::leave(static_cast<InterruptProfiler::Vector>(InterruptProfiler::VECTOR_INT0 + INTERRUPT),
+                                 start);
+#else
+        countPulse(readPhaseB() != FW_LEVEL);
+#endif
+    }
+
+  private:
+    /// Read phase B straight from its port, pins 0-7 are on port D, 8-13 on port B and A0-A5 on port C.
+    static inline bool readPhaseB()
+    {
+        if (PIN_PHASE_B < 8)
+        {
+            return PIND & (1 << PIN_PHASE_B);
+        }
+
+        if (PIN_PHASE_B < 14)
+        {
+            return PINB & (1 << ((PIN_PHASE_B - 8) & 7));
+        }
+
+        return PINC & (1 << ((PIN_PHASE_B - 14) & 7));
+    }
+};
+#endif
+
 #endif
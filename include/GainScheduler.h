@@ -0,0 +1,94 @@
+/// Gain scheduling across a table of PID gain profiles.
+
+#ifndef _GAIN_SCHEDULER_H_
+#define _GAIN_SCHEDULER_H_
+
+#include "PIDController.h"
+#include "configuration.h"
+#include <stdint.h>
+
+struct GainProfile
+{
+    /// Value of the scheduling variable where the profile applies as is.
+    float breakpoint;
+
+    float balance_kp, balance_ki, balance_kd;
+    float velocity_kp, velocity_ki, velocity_kd;
+};
+
+class GainScheduler
+{
+  public:
+    /// Variable used to interpolate between the profiles.
+    enum class Source : uint8_t
+    {
+        /// Apply the selected profile as is.
+        NONE,
+        /// [rad] Absolute inclination.
+        ANGLE,
+        /// [rev/s] Absolute average wheel speed.
+        SPEED,
+        /// [V] Battery voltage.
+        VOLTAGE,
+    };
+
+    GainScheduler(PIDController &balance_loop, PIDController &velocity_loop);
+
+    /// Get the profile at the given index.
+    inline GainProfile &getProfile(uint8_t index)
+    {
+        return profiles_[index];
+    }
+
+    /// Get the profile edited by the gain properties and applied when scheduling is disabled.
+    inline GainProfile &getSelectedProfile()
+    {
+        return profiles_[selected_];
+    }
+
+    /// Get the index of the selected profile.
+    inline uint8_t getSelected()
+    {
+        return selected_;
+    }
+
+    /// Select a profile, switching to it without bumps when scheduling is disabled.
+    void select(uint8_t index);
+
+    /// Apply the profiles again after they have been modified.
+    void apply();
+
+    /// Get the scheduling variable.
+    inline Source getSource()
+    {
+        return source_;
+    }
+
+    /// Set the scheduling variable, profiles must be sorted by ascending breakpoint.
+    void setSource(Source source);
+
+    /// Interpolate the gains from the current value of the scheduling variable.
+    /// Gains are only updated when the variable leaves the range of the applied interpolation step, without bumps.
+    void update(float angle, float speed, float voltage);
+
+  private:
+    static_assert(GAIN_PROFILE_COUNT >= 2, "At least two gain profiles are needed for interpolation.");
+
+    /// Number of interpolation steps between two adjacent profiles.
+    static const uint8_t INTERPOLATION_STEPS = 16;
+
+    PIDController &balance_loop_;
+    PIDController &velocity_loop_;
+
+    GainProfile profiles_[GAIN_PROFILE_COUNT];
+    uint8_t selected_ = 0;
+    Source source_ = Source::NONE;
+
+    /// Last applied interpolation point, negative when the gains need to be recomputed.
+    int16_t point_ = -1;
+
+    /// Range of the scheduling variable covered by the applied interpolation point.
+    float step_min_, step_max_;
+};
+
+#endif // _GAIN_SCHEDULER_H_
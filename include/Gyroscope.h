@@ -4,6 +4,7 @@
 #define _GYROSCOPE_H_
 
 // clang-format off
+#include "configuration.h"
 #include <inttypes.h>
 #include <math.h>
 #include <helper_3dmath.h>
@@ -19,14 +20,48 @@ class Gyroscope
         int32_t x, y, z;
     };
 
+    /// Result of a calibration.
+    struct Calibration
+    {
+        Offset offset_accel, offset_gyro;
+
+        /// Raw readings averaged with the new offsets applied, the accelerometer Z axis excludes gravity.
+        Offset residual_accel, residual_gyro;
+
+        float zero_angle;
+    };
+
     Gyroscope(uint8_t address, float zero_angle, Offset offset_accel, Offset offset_gyro);
 
+    /// Set up the sensor, the DMP firmware upload is skipped if the sensor kept its configuration across a reset.
     void begin();
-    void tick();
+
+    /// Whether the last begin found the sensor already configured.
+    inline bool isWarmStart()
+    {
+        return warm_start_;
+    }
+
+    /// Read the latest sample from the sensor.
+    /// Returns true if a new sample was read.
+    bool tick();
 
     /// Read the current inclination in the range PI to -PI.
     float getAngle();
 
+    /// [rad/s] Read the current rate of change of the inclination.
+    float getAngleRate();
+
+    /// [m/s^2] Read the current horizontal acceleration along the sensor X axis, forward when leaning to negative
+    /// angles accelerates the robot forward.
+    float getForwardAcceleration();
+
+    /// [ms] Get the interval between samples, measured at startup when using the DMP.
+    inline float getSamplePeriod()
+    {
+        return sample_period_;
+    }
+
     /// Get the gyroscope zero offset.
     inline float getZeroAngle()
     {
@@ -39,17 +74,106 @@ class Gyroscope
         zero_angle_ = zero_angle;
     }
 
+    /// Get the accelerometer offsets.
+    inline Offset getOffsetAccel()
+    {
+        return offset_accel_;
+    }
+
+    /// Get the gyroscope offsets.
+    inline Offset getOffsetGyro()
+    {
+        return offset_gyro_;
+    }
+
+    /// Set the offsets loaded into the sensor by begin.
+    inline void setOffsets(Offset offset_accel, Offset offset_gyro)
+    {
+        offset_accel_ = offset_accel;
+        offset_gyro_ = offset_gyro;
+    }
+
+    /// Compute and apply the offsets and the zero angle from the raw readings.
+    /// The robot must be held still at its balance point, blocks for a few seconds. Returns false, leaving the offsets
+    /// unchanged, if the readings lean more than max_angle [rad] from the balance point of the previous calibration.
+    bool calibrate(float max_angle, Calibration &calibration);
+
+#ifndef GYRO_RAW_ESTIMATOR
+    /// Private method, replaces the latest sample with a DMP packet.
+    void _loadPacket(const uint8_t *packet);
+#endif
+
   private:
-    /// [ms] Lapse of time to wait for the output to stabilize,
-    /// might need a longer timeout depending on initial orientation.
+    /// [ms] Maximum lapse of time to wait for the output to stabilize.
     static const uint32_t OUTPUT_STABILIZATION_DELAY = 1000;
 
+    /// [m/s^2]
+    static const constexpr float GRAVITY = 9.81;
+
     uint8_t address_;
     float zero_angle_;
     Offset offset_accel_, offset_gyro_;
+    bool warm_start_ = false;
+    float sample_period_;
 
     MPU6050 mpu_;
-    uint8_t fifo_buffer_[64];
+
+#ifdef GYRO_RAW_ESTIMATOR
+    /// [LSB/(rad/s)] Gyroscope sensitivity in the +-250°/s full scale range.
+    static const constexpr float GYRO_SENSITIVITY = 131.0 * 180.0 / M_PI;
+
+    /// Fixed point estimator units in one radian, each unit is one gyroscope LSB integrated over one sample period.
+    static const constexpr float ANGLE_UNITS_PER_RAD = GYRO_SENSITIVITY * (1000000.0 / GYRO_RAW_ESTIMATOR_PERIOD);
+
+    static const int32_t ANGLE_UNITS_PI = M_PI * ANGLE_UNITS_PER_RAD;
+
+    /// Maximum number of missed sample periods that will be integrated in a single tick.
+    static const uint8_t MAX_MISSED_SAMPLES = 20;
+
+    uint32_t last_sample_;
+    uint8_t accel_samples_ = 0;
+
+    int32_t angle_ = 0;
+    int16_t angle_rate_ = 0;
+
+    /// Last accelerometer reading of the estimator.
+    int16_t accel_x_ = 0, accel_z_ = 0;
+
+    /// Convert a raw accelerometer reading to the estimator units.
+    static int32_t accelToAngle(int16_t accel_x, int16_t accel_z);
+
+    /// Bring the fixed point angle in the range PI to -PI.
+    static int32_t wrapAngle(int32_t angle);
+#else
+    /// [LSB/(rad/s)] Gyroscope sensitivity in the +-2000°/s full scale range configured by the DMP firmware.
+    static const constexpr float GYRO_SENSITIVITY = 16.4 * 180.0 / M_PI;
+
+    /// [bytes] Size of the DMP packets: quaternion, accelerometer and gyroscope.
+    static const uint8_t PACKET_SIZE = 28;
+
+    /// [bytes] Size of the sensor FIFO.
+    static const uint16_t FIFO_SIZE = 1024;
+
+    /// Bytes at the end of the DMP firmware compared to detect a warm start.
+    static const uint8_t FIRMWARE_CHECK_SIZE = 16;
+
+    uint8_t fifo_buffer_[PACKET_SIZE];
+
+    /// Whether the sensor still runs the DMP firmware with the configured offsets.
+    bool isConfigured();
+
+    /// Wait for the angle to settle, up to OUTPUT_STABILIZATION_DELAY.
+    void waitConvergence();
+#endif
+
+    /// [m/s^2] Horizontal acceleration from the raw specific force and the sine and cosine of the pitch.
+    static float forwardAcceleration(int16_t accel_x, int16_t accel_z, float sin_pitch, float cos_pitch);
+
+    /// Load the configured offsets into the sensor.
+    void applyOffsets();
+
+    /// Average GYRO_CALIBRATION_SAMPLES raw readings.
+    void averageReadings(Offset &accel, Offset &gyro);
 };
 
 #endif
@@ -0,0 +1,85 @@
+/// Interrupt load instrumentation.
+
+#ifndef _INTERRUPT_PROFILER_H_
+#define _INTERRUPT_PROFILER_H_
+
+#include <Arduino.h>
+#include <stdint.h>
+
+class InterruptProfiler
+{
+  public:
+    /// Instrumented interrupt vectors.
+    enum Vector : uint8_t
+    {
+        VECTOR_INT0,
+        VECTOR_INT1,
+        VECTOR_ADC,
+    };
+
+    struct Stats
+    {
+        uint32_t cycles, count;
+        uint16_t max_cycles;
+    };
+
+    /// Take over Timer2 as a cycle counter and start sampling the interrupt latency on the Timer1 overflow.
+    /// Must be called after the motors have configured the timers.
+    static void begin();
+
+    /// Clear the collected statistics.
+    static void reset();
+
+    /// Mark the start of an interrupt handler, the result is passed to leave().
+    static inline uint8_t enter()
+    {
+        return TCNT2;
+    }
+
+    /// Mark the end of an interrupt handler.
+    static inline void leave(Vector vector, uint8_t start)
+    {
+        uint16_t cycles = static_cast<uint8_t>(TCNT2 - start) * CYCLES_PER_TICK;
+        Stats &stats = stats_[vector];
+
+        stats.cycles += cycles;
+        stats.count++;
+
+        if (cycles > stats.max_cycles)
+        {
+            stats.max_cycles = cycles;
+        }
+    }
+
+    /// Get a consistent copy of the statistics of a vector.
+    static Stats getStats(Vector vector);
+
+    /// [us] Get the longest delay observed before an interrupt could be serviced.
+    static uint16_t getMaxBlocked();
+
+    /// Private method.
+    static inline void _onLatencySample()
+    {
+        // Timer1 counts up from zero after overflowing, so its value is the time since the interrupt was raised.
+        uint16_t blocked = TCNT1 * US_PER_LATENCY_TICK;
+
+        if (blocked > max_blocked_)
+        {
+            max_blocked_ = blocked;
+        }
+    }
+
+  private:
+    static const size_t VECTOR_COUNT = VECTOR_ADC + 1;
+
+    /// CPU cycles per Timer2 tick, the counter wraps around every 256 ticks.
+    static const uint8_t CYCLES_PER_TICK = 8;
+
+    /// [us] Duration of a Timer1 tick with the prescaler set up by the Arduino core.
+    static const uint8_t US_PER_LATENCY_TICK = 64 / (F_CPU / 1000000);
+
+    static Stats stats_[VECTOR_COUNT];
+    static volatile uint16_t max_blocked_;
+};
+
+#endif // _INTERRUPT_PROFILER_H_
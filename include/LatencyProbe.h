@@ -0,0 +1,68 @@
+/// Sensor to actuator latency instrumentation.
+
+#ifndef _LATENCY_PROBE_H_
+#define _LATENCY_PROBE_H_
+
+#include "configuration.h"
+#include <stddef.h>
+#include <stdint.h>
+
+class LatencyProbe
+{
+  public:
+    /// Control cycle checkpoints, in pipeline order.
+    enum Stage : uint8_t
+    {
+        /// A new sample has been read from the sensor.
+        SAMPLE,
+        /// The inclination has been computed from the sample.
+        ANGLE,
+        /// The PID loop has computed a new output.
+        CONTROL,
+        /// The motor outputs have been updated, completes the cycle.
+        ACTUATION,
+    };
+
+    /// Set up the correlation output pin if one is configured.
+    void begin();
+
+    /// Record the current time for the given stage.
+    /// Marking the ACTUATION stage adds the sensor to actuator latency of the cycle to the statistics.
+    void mark(Stage stage);
+
+    /// Clear the collected statistics.
+    void reset();
+
+    /// [us] Get the minimum measured latency.
+    uint32_t getMin();
+
+    /// [us] Get the average measured latency.
+    uint32_t getMean();
+
+    /// [us] Get the maximum measured latency.
+    uint32_t getMax();
+
+    /// [us] Get the 99th percentile of the measured latency, rounded up to the histogram resolution.
+    uint32_t getPercentile99();
+
+    /// [us] Get the time elapsed between the sample and the given stage during the last complete cycle.
+    uint32_t getStageDelay(Stage stage);
+
+  private:
+    static const size_t STAGE_COUNT = ACTUATION + 1;
+
+    /// Number of histogram buckets, the last one also collects every latency beyond the histogram range.
+    static const size_t HISTOGRAM_LEN = 32;
+
+    uint32_t timestamps_[STAGE_COUNT];
+    uint32_t delays_[STAGE_COUNT];
+
+    uint32_t min_, max_, sum_;
+    uint16_t count_;
+    uint16_t histogram_[HISTOGRAM_LEN];
+
+    /// Add a sample to the statistics.
+    void record(uint32_t latency);
+};
+
+#endif // _LATENCY_PROBE_H_
@@ -0,0 +1,107 @@
+/// Jerk and acceleration limited speed trajectory with lean angle feedforward.
+
+#ifndef _MOTION_PROFILE_H_
+#define _MOTION_PROFILE_H_
+
+#include <stdint.h>
+
+class MotionProfile
+{
+  public:
+    MotionProfile(float sample_time, float max_acceleration, float max_jerk, float travel_per_revolution,
+                  float max_lean);
+
+    /// Advance the trajectory towards the target, returns true when a new sample was computed.
+    bool tick();
+
+    /// Stop the trajectory at zero speed, the target is kept.
+    void reset();
+
+    /// [ms] Set the interval between trajectory samples.
+    inline void setSampleTime(float sample_time)
+    {
+        sample_time_ = sample_time;
+    }
+
+    /// [rev/s] Get the speed the trajectory is heading to.
+    inline float getTarget()
+    {
+        return target_;
+    }
+
+    /// [rev/s] Set the speed the trajectory is heading to.
+    inline void setTarget(float target)
+    {
+        target_ = target;
+    }
+
+    /// [rev/s] Get the current speed of the trajectory.
+    inline float getSpeed()
+    {
+        return speed_;
+    }
+
+    /// [rev/s^2] Get the current acceleration of the trajectory.
+    inline float getAcceleration()
+    {
+        return acceleration_;
+    }
+
+    /// [rad] Get the steady state inclination that produces the current acceleration, up to the lean limit, zero
+    /// when disabled.
+    float getLean();
+
+    /// [rev/s^2] Get the acceleration limit.
+    inline float getMaxAcceleration()
+    {
+        return max_acceleration_;
+    }
+
+    /// [rev/s^2] Set the acceleration limit, zero disables the profile and steps to the target.
+    inline void setMaxAcceleration(float max_acceleration)
+    {
+        max_acceleration_ = max_acceleration;
+    }
+
+    /// [rev/s^3] Get the jerk limit.
+    inline float getMaxJerk()
+    {
+        return max_jerk_;
+    }
+
+    /// [rev/s^3] Set the jerk limit, zero only limits the acceleration.
+    inline void setMaxJerk(float max_jerk)
+    {
+        max_jerk_ = max_jerk;
+    }
+
+    /// Check whether the lean angle feedforward is enabled.
+    inline bool getFeedforward()
+    {
+        return feedforward_;
+    }
+
+    /// Enable the lean angle feedforward.
+    inline void setFeedforward(bool feedforward)
+    {
+        feedforward_ = feedforward;
+    }
+
+  private:
+    /// [m/s^2]
+    static constexpr float GRAVITY = 9.81;
+
+    float sample_time_;
+    uint32_t last_sample_ = 0;
+
+    float max_acceleration_, max_jerk_;
+    /// [m/rev]
+    float travel_per_revolution_;
+    /// [rad]
+    float max_lean_;
+    bool feedforward_ = true;
+
+    float target_ = 0, speed_ = 0, acceleration_ = 0;
+};
+
+#endif // _MOTION_PROFILE_H_
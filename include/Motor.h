@@ -16,6 +16,9 @@ class Motor
     /// Set the motor duty cycle and direction.
     void setDuty(int8_t duty);
 
+    /// Release both driver inputs so that the motor spins freely.
+    void coast();
+
   private:
     uint8_t pin_fw_, pin_bw_;
 
@@ -0,0 +1,27 @@
+/// Dead reckoning from the wheel encoder positions.
+
+#ifndef _ODOMETRY_H_
+#define _ODOMETRY_H_
+
+#include <stdint.h>
+
+class Odometry
+{
+  public:
+    Odometry(float travel_per_pulse, float wheel_base);
+
+    /// Update the estimate with the latest encoder positions.
+    void update(int32_t position_l, int32_t position_r);
+
+    /// [m] Get the distance travelled forward since startup.
+    float getDistance();
+
+    /// [rad] Get the heading change since startup, positive when turning left.
+    float getHeading();
+
+  private:
+    float travel_per_pulse_, wheel_base_;
+    int32_t position_l_ = 0, position_r_ = 0;
+};
+
+#endif // _ODOMETRY_H_
@@ -15,6 +15,10 @@ class PIDController : PID
         return PID::Compute();
     }
 
+    /// Performs the PID calculation, taking the derivative term from the measured rate of change of the input
+    /// when derivative on rate is enabled. It should be called every time loop() cycles.
+    bool compute(float input, float input_rate);
+
     /// Enable the PID loop.
     inline void enable()
     {
@@ -28,12 +32,38 @@ class PIDController : PID
         SetMode(MANUAL);
     }
 
+    /// Check whether the PID loop is enabled.
+    inline bool isEnabled()
+    {
+        return GetMode() == AUTOMATIC;
+    }
+
+    /// [ms] Get the sample period.
+    inline uint16_t getSamplePeriod()
+    {
+        return sample_period_;
+    }
+
+    /// [ms] Set the sample period, the PID library rescales the discrete integral and derivative gains
+    /// so that the continuous time tunings are preserved.
+    inline void setSamplePeriod(uint16_t sample_period)
+    {
+        sample_period_ = sample_period;
+        SetSampleTime(sample_period);
+    }
+
     /// Get the last computed result.
     inline float getOutput()
     {
         return output_;
     }
 
+    /// Get the PID setpoint value.
+    inline float getTarget()
+    {
+        return setpoint_;
+    }
+
     /// Set the PID setpoint value.
     inline void setTarget(float target)
     {
@@ -67,17 +97,51 @@ class PIDController : PID
     /// Get the PID derivative term.
     inline float getKd()
     {
-        return GetKd();
+        return kd_;
     }
 
     /// Set the PID derivative term.
     inline void setKd(float kd)
     {
-        SetTunings(GetKp(), GetKi(), kd);
+        kd_ = kd;
+        SetTunings(GetKp(), GetKi(), derivative_on_rate_ ? 0 : kd);
+    }
+
+    /// Set all the PID terms at once.
+    inline void setTunings(float kp, float ki, float kd)
+    {
+        kd_ = kd;
+        SetTunings(kp, ki, derivative_on_rate_ ? 0 : kd);
+    }
+
+    /// Set all the PID terms at once, loading the integral term so that the output does not jump.
+    void transferTunings(float kp, float ki, float kd);
+
+    /// Check whether the derivative term is computed from the measured input rate.
+    inline bool getDerivativeOnRate()
+    {
+        return derivative_on_rate_;
+    }
+
+    /// Compute the derivative term from the measured input rate instead of differentiating the input.
+    inline void setDerivativeOnRate(bool derivative_on_rate)
+    {
+        derivative_on_rate_ = derivative_on_rate;
+        SetOutputLimits(output_min_, output_max_);
+        setKd(kd_);
     }
 
   private:
     float input_, output_, setpoint_ = 0;
+    float output_min_, output_max_;
+    bool direct_;
+    uint16_t sample_period_;
+
+    float kd_ = 0;
+    bool derivative_on_rate_ = false;
+
+    /// Input rate of the last computation with derivative on rate.
+    float input_rate_ = 0;
 };
 
 #endif // _PID_CONTROLLER_H_
@@ -0,0 +1,48 @@
+/// Control pipeline composed at compile time.
+///
+/// A stage is a type with a static RATE and a static run(SIGNALS &) that returns true when it produced a new output
+/// on this pass. The stages run in the order they are listed and exchange data through the signals. The composition
+/// unrolls into a straight sequence of calls that the compiler inlines, without objects, virtual calls or function
+/// pointers.
+///
+///     typedef Pipeline<Signals, Sensor, Estimator, Controller, Actuator> ControlPipeline;
+///     ControlPipeline::run(signals);
+
+#ifndef _PIPELINE_H_
+#define _PIPELINE_H_
+
+#include <stdint.h>
+
+/// When a pipeline stage runs.
+enum class Rate : uint8_t
+{
+    /// On every pass, the stage keeps its own sample timing.
+    CYCLE,
+    /// Only on the passes where the previous stage produced a new output.
+    TRIGGERED,
+};
+
+template <typename SIGNALS, typename... STAGES> struct Pipeline;
+
+template <typename SIGNALS> struct Pipeline<SIGNALS>
+{
+    static inline __attribute__((always_inline)) bool run(SIGNALS &, bool triggered = true)
+    {
+        return triggered;
+    }
+};
+
+template <typename SIGNALS, typename STAGE, typename... STAGES> struct Pipeline<SIGNALS, STAGE, STAGES...>
+{
+    static_assert(STAGE::RATE == Rate::CYCLE || STAGE::RATE == Rate::TRIGGERED, "Unknown stage rate.");
+
+    /// Run one pass of the stages, returns whether the last one produced a new output.
+    static inline __attribute__((always_inline)) bool run(SIGNALS &signals, bool triggered = true)
+    {
+        // The rate is a constant, the check folds away for stages that run on every pass.
+        bool produced = (STAGE::RATE == Rate::CYCLE || triggered) && STAGE::run(signals);
+        return Pipeline<SIGNALS, STAGES...>::run(signals, produced);
+    }
+};
+
+#endif // _PIPELINE_H_
@@ -0,0 +1,66 @@
+/// Pseudo random binary excitation for system identification.
+
+#ifndef _SYSTEM_IDENTIFIER_H_
+#define _SYSTEM_IDENTIFIER_H_
+
+#include <stdint.h>
+
+class SystemIdentifier
+{
+  public:
+    SystemIdentifier(uint8_t amplitude, uint8_t bit_period);
+
+    /// Restart the sequence and the sample count.
+    void enable();
+
+    void disable();
+
+    inline bool isEnabled()
+    {
+        return enabled_;
+    }
+
+    /// Get the duty to add to the stabilizing output in the next control sample, zero while disabled.
+    int16_t next();
+
+    /// Get the number of control samples excited since enabled.
+    inline uint32_t getSample()
+    {
+        return sample_;
+    }
+
+    /// Get the duty added or subtracted by the excitation.
+    inline uint8_t getAmplitude()
+    {
+        return amplitude_;
+    }
+
+    inline void setAmplitude(uint8_t amplitude)
+    {
+        amplitude_ = amplitude;
+    }
+
+    /// Get the number of control samples each bit of the sequence is held for.
+    inline uint8_t getBitPeriod()
+    {
+        return bit_period_;
+    }
+
+    inline void setBitPeriod(uint8_t bit_period)
+    {
+        bit_period_ = bit_period;
+    }
+
+  private:
+    /// Initial state of the linear feedback shift register, any non zero value.
+    static const uint16_t LFSR_SEED = 0x1FF;
+
+    uint8_t amplitude_, bit_period_;
+    bool enabled_ = false;
+
+    uint16_t lfsr_ = LFSR_SEED;
+    uint8_t bit_samples_ = 0;
+    uint32_t sample_ = 0;
+};
+
+#endif // _SYSTEM_IDENTIFIER_H_
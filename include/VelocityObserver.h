@@ -0,0 +1,74 @@
+/// Forward velocity estimate fusing the accelerometer and the wheel encoders.
+
+#ifndef _VELOCITY_OBSERVER_H_
+#define _VELOCITY_OBSERVER_H_
+
+#include <stdint.h>
+
+class VelocityObserver
+{
+  public:
+    VelocityObserver(float travel_per_revolution, uint8_t gain_shift, uint8_t bias_shift);
+
+    /// Integrate the forward acceleration over the time since the previous prediction.
+    void predict(float acceleration);
+
+    /// Correct the estimate with the speed measured by the encoders over the window since the previous correction.
+    void correct(float speed);
+
+    /// [ms] Set the length of the encoder window, over which the corrected speeds are measured.
+    void setWindow(uint16_t period);
+
+    /// Restart the estimate from the given speed and forget the acceleration bias.
+    void reset(float speed);
+
+    /// [rev/s] Get the estimated speed.
+    inline float getSpeed()
+    {
+        return speed_ / static_cast<float>(ONE);
+    }
+
+    /// [rev/s^2] Get the estimated accelerometer bias.
+    inline float getBias()
+    {
+        return bias_ / static_cast<float>(ONE);
+    }
+
+    inline bool isEnabled()
+    {
+        return enabled_;
+    }
+
+    inline void setEnabled(bool enabled)
+    {
+        enabled_ = enabled;
+    }
+
+  private:
+    /// Fixed point units in one rev/s, and in one rev/s^2 for the accelerations.
+    static const int32_t ONE = 1L << 16;
+
+    /// [us] Longest interval integrated by a single prediction.
+    static const uint32_t MAX_PREDICT_INTERVAL = 100000;
+
+    /// 2^32 / 10^6, converts microseconds to seconds in Q0.32.
+    static const uint32_t SECONDS_PER_US_Q32 = 4295;
+
+    bool enabled_ = false;
+
+    /// [units/(m/s^2)]
+    float acceleration_scale_;
+    uint8_t gain_shift_, bias_shift_;
+
+    /// [1/s] Converts a speed innovation into the accelerometer bias causing it, twice the encoder window rate.
+    float bias_rate_ = 0;
+
+    uint32_t last_predict_ = 0;
+
+    int32_t speed_ = 0, bias_ = 0;
+
+    /// Estimated speed when the current encoder window started.
+    int32_t window_start_ = 0;
+};
+
+#endif // _VELOCITY_OBSERVER_H_
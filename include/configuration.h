@@ -1,6 +1,19 @@
 #ifndef _CONFIGURATION_H_
 #define _CONFIGURATION_H_
 
+// Serial
+
+#ifndef SERIAL_BAUD_RATE
+/// Default serial link rate, can be overridden with a build flag. Rates up to 1000000 are supported at 16MHz.
+#define SERIAL_BAUD_RATE 9600
+#endif
+
+/// [us] Default time budget for processing serial requests in each loop cycle.
+#define COMM_TICK_BUDGET 2000
+
+/// Largest number of consecutive loop cycles that shed the serial requests because the previous one overran.
+#define COMM_MAX_SHED_CYCLES 8
+
 // Gyroscope
 
 /// Gyroscope module X axis accelerometer offset.
@@ -22,6 +35,25 @@
 /// Gyroscope module i2c address.
 #define GYRO_ADDRESS 0x68
 
+/// Uncomment to bypass the DMP and estimate the inclination on the MCU from the raw sensor readings.
+// #define GYRO_RAW_ESTIMATOR
+/// [us] Sample period of the raw sensor estimator.
+#define GYRO_RAW_ESTIMATOR_PERIOD 1000
+/// Number of gyroscope samples between each accelerometer correction of the raw sensor estimator.
+#define GYRO_RAW_ESTIMATOR_ACCEL_DECIMATION 10
+/// Weight of each accelerometer correction of the raw sensor estimator, expressed as a right shift.
+#define GYRO_RAW_ESTIMATOR_ACCEL_SHIFT 4
+
+/// [rad] Largest change between consecutive DMP samples for the angle to be considered settled at startup.
+#define GYRO_CONVERGENCE_TOLERANCE 0.001
+/// Number of consecutive settled DMP samples needed to end the startup wait.
+#define GYRO_CONVERGENCE_SAMPLES 10
+
+/// Number of raw readings averaged by each of the two calibration passes.
+#define GYRO_CALIBRATION_SAMPLES 256
+/// [ms] Interval between raw readings during calibration.
+#define GYRO_CALIBRATION_SAMPLE_PERIOD 5
+
 // Motors
 
 /// Motor driver pin for running the left motor forward.
@@ -36,17 +68,48 @@
 
 // PID loops
 
-/// Sample period of the balancing PID loop.
+/// [ms] Default sample period of the balancing PID loop.
 #define BALANCE_PID_SAMPLE_PERIOD 10
+/// [ms] Shortest sample period accepted for the balancing PID loop, a loop cycle serving requests takes a few ms.
+#define BALANCE_PID_MIN_SAMPLE_PERIOD 5
 /// Default proportional parameter of the balancing PID loop.
 #define BALANCE_PID_KP 650.0
 /// Default integral parameter of the balancing PID loop.
 #define BALANCE_PID_KI 3200.0
 /// Default derivative parameter of the balancing PID loop.
 #define BALANCE_PID_KD 45.0
-
-/// Sample period of the velocity PID loop.
+/// Default derivative source of the balancing PID loop, true to use the gyroscope rate instead of the angle delta.
+#define BALANCE_PID_D_ON_RATE false
+
+/// [ms] Default horizon of the inclination predictor, zero disables the prediction.
+#define ANGLE_PREDICTOR_HORIZON 0.0
+/// [rad/s^2] Default angular acceleration produced by a unit of duty, used by the inclination predictor.
+#define ANGLE_PREDICTOR_DUTY_GAIN 0.0
+
+/// Default state of the disturbance observer, which adds a duty cancelling the external torques.
+#define OBSERVER_ENABLED false
+/// [Hz] Default cut-off frequency of the disturbance estimate.
+#define OBSERVER_BANDWIDTH 2.0
+/// [1/s^2] Default angular acceleration produced by a unit of inclination, the a of the fitted pendulum model.
+#define OBSERVER_STIFFNESS 0.0
+/// [rad/s^2] Default angular acceleration produced by a unit of duty, the b of the fitted pendulum model.
+#define OBSERVER_DUTY_GAIN 0.0
+/// Maximum duty added by the disturbance observer.
+#define OBSERVER_MAX_DUTY 64.0
+
+/// Default duty added or subtracted by the system identification excitation.
+#define SYSID_AMPLITUDE 20
+/// Default number of balance loop samples each bit of the system identification excitation is held for.
+#define SYSID_BIT_PERIOD 2
+
+/// Number of gain profiles stored in EEPROM for gain scheduling.
+/// Each profile is initialized with the default balance and velocity parameters and a breakpoint equal to its index.
+#define GAIN_PROFILE_COUNT 3
+
+/// [ms] Default sample period of the velocity PID loop, also used by the position hold loop and the encoders.
 #define VELOCITY_PID_SAMPLE_PERIOD 100
+/// [ms] Longest sample period accepted for the velocity PID loop.
+#define VELOCITY_PID_MAX_SAMPLE_PERIOD 1000
 /// Default proportional parameter of the velocity PID loop.
 #define VELOCITY_PID_KP 0.0
 /// Default integral parameter of the velocity PID loop.
@@ -54,15 +117,86 @@
 /// Default derivative parameter of the velocity PID loop.
 #define VELOCITY_PID_KD 0.0
 
+/// Sample period of the position hold PID loop.
+#define POSITION_PID_SAMPLE_PERIOD VELOCITY_PID_SAMPLE_PERIOD
+/// Default proportional parameter of the position hold PID loop.
+#define POSITION_PID_KP 0.0
+/// Default integral parameter of the position hold PID loop.
+#define POSITION_PID_KI 0.0
+/// Default derivative parameter of the position hold PID loop.
+#define POSITION_PID_KD 0.0
+/// [rev/s] Maximum speed that can be requested by the position hold PID loop.
+#define POSITION_PID_MAX_SPEED 5.0
+
+/// [rev/s^2] Default acceleration limit of the speed trajectory, zero steps the velocity loop target directly.
+#define MOTION_MAX_ACCELERATION 100.0
+/// [rev/s^3] Default jerk limit of the speed trajectory, zero only limits the acceleration.
+#define MOTION_MAX_JERK 500.0
+/// Default state of the lean angle feedforward from the speed trajectory acceleration.
+#define MOTION_FEEDFORWARD true
+
+/// Default proportional parameter of the wheel speed PID loops, which run at the encoder sample rate.
+#define WHEEL_PID_KP 0.0
+/// Default integral parameter of the wheel speed PID loops.
+#define WHEEL_PID_KI 0.0
+/// Maximum duty each wheel speed PID loop can add to or subtract from the balance loop output.
+#define WHEEL_PID_MAX_DUTY 32.0
+
+/// Default gain applied to the balance loop output on the left motor.
+#define MOTOR_TRIM_LEFT 1.0
+/// Default gain applied to the balance loop output on the right motor.
+#define MOTOR_TRIM_RIGHT 1.0
+/// Smallest motor trim accepted.
+#define MOTOR_TRIM_MIN 0.5
+/// Largest motor trim accepted.
+#define MOTOR_TRIM_MAX 1.5
+
+// Filters
+
+/// Number of biquad sections at each filter insertion point, all of them pass the signal through by default.
+#define BIQUAD_SECTIONS 2
+/// [1/rad] Fixed point scale of the angle filter, which runs at the gyroscope sample rate.
+#define FILTER_ANGLE_SCALE 4096.0
+/// [s/rev] Fixed point scale of the velocity filter, which runs at the encoder sample rate.
+#define FILTER_VELOCITY_SCALE 256.0
+/// Fixed point scale of the duty filter, which runs at the balance loop sample rate.
+#define FILTER_DUTY_SCALE 64.0
+
+// Battery
+
+/// Analog pin connected to the battery voltage divider.
+#define PIN_BATTERY A0
+/// Ratio between the battery voltage and the voltage at the divider output.
+#define BATTERY_DIVIDER_RATIO 3.0
+/// [V] Battery voltage the loop gains are tuned for.
+#define BATTERY_NOMINAL_VOLTAGE 7.4
+/// [V] Readings below this voltage are treated as a disconnected battery sense line.
+#define BATTERY_MIN_VOLTAGE 3.0
+/// Default state of the motor duty compensation for the battery voltage.
+#define BATTERY_COMPENSATION false
+
 // Encoders
 
 /// Number of encoder pulses for each motor revolution.
 #define ENCODER_PULSES_PER_REVOLUTION 8
 
-/// [ms] Sample period of the encoder.
-/// Please note that VELOCITY_PID_SAMPLE_PERIOD should be a multiple of ENCODER_SAMPLE_PERIOD.
+/// [m] Distance travelled by the wheel for each motor revolution.
+#define WHEEL_TRAVEL_PER_REVOLUTION 0.00425
+/// [m] Distance between the contact points of the two wheels.
+#define WHEEL_BASE 0.16
+
+/// [ms] Sample period of the encoder, follows the velocity PID loop period at runtime.
+/// With the velocity observer enabled, the encoders sample at least this long and the velocity loop can run faster.
 #define ENCODER_SAMPLE_PERIOD VELOCITY_PID_SAMPLE_PERIOD
 
+/// Default state of the velocity observer, which predicts the speed from the accelerometer between encoder samples.
+#define VELOCITY_OBSERVER_ENABLED false
+/// The velocity observer moves its estimate by 1/2^shift of the difference with each encoder sample.
+#define VELOCITY_OBSERVER_GAIN_SHIFT 1
+/// The velocity observer moves its accelerometer bias by 1/2^shift of the bias implied by each encoder
+/// sample. Below 2 the estimate does not settle.
+#define VELOCITY_OBSERVER_BIAS_SHIFT 2
+
 /// Arduino pin connected to the left encoder's A phase.
 #define PIN_ENCODER_L_A 2
 /// Arduino pin connected to the left encoder's B phase.
@@ -76,6 +210,8 @@
 #define PIN_ENCODER_R_B 7
 /// Logic level of the phase B pin when receiving a pulse on phase A while going forward.
 #define PIN_ENCODER_R_FW_LEVEL HIGH
+/// Uncomment to bind the encoders to the INT0 and INT1 vectors at compile time instead of using attachInterrupt.
+// #define ENCODER_DIRECT_ISR
 
 // Startup
 
@@ -94,4 +230,26 @@
 /// [°/s] Maximum rate of change of the angle before the robot will switch on and try to stabilize.
 // #define STARTUP_ANGLE_DELTA 10
 
+// Idle
+
+/// Default state of the low power idle mode, entered while the robot lies outside STARTUP_ANGLE.
+#define IDLE_ENABLED true
+/// [ms] Lapse of time that the robot needs to stay stopped outside STARTUP_ANGLE before going idle.
+#define IDLE_DELAY 5000
+
+// Instrumentation
+
+/// Uncomment to measure the latency between each gyroscope sample and the motor output update.
+// #define LATENCY_PROBE
+/// Uncomment to drive the given pin high between each gyroscope sample and the motor output update.
+// #define LATENCY_PROBE_PIN 12
+/// [us] Resolution of the latency histogram.
+#define LATENCY_PROBE_BUCKET_WIDTH 250
+
+/// Uncomment to account the cycles spent in the interrupt handlers and to detect missed encoder pulses.
+/// Timer2 is taken over as a cycle counter, so PWM on pins 3 and 11 becomes unavailable.
+// #define INTERRUPT_PROFILER
+/// [us] Longest gap between encoder pulses after which a 1.5 times longer gap is counted as a missed pulse.
+#define ENCODER_MISSED_PULSE_MAX_GAP 2000
+
 #endif
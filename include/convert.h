@@ -3,8 +3,16 @@
 #ifndef _CONVERT_H_
 #define _CONVERT_H_
 
-/// Convert a null terminated string to a floating point value.
+#include <stdint.h>
+
+/// Convert a null terminated decimal string to a floating point value, exponent notation is not supported.
+/// Runs in bounded time, digits beyond the 32 bit mantissa precision are ignored.
 /// Returns NaN if an error occured during the conversion.
 double stringToDouble(char *str);
 
+/// Write a floating point value to the buffer as a decimal string with the given number of decimals, at most 9.
+/// Runs in bounded time, writes "ovf" if the integer part does not fit 32 bits.
+/// Returns the buffer.
+char *doubleToString(double value, uint8_t precision, char *buffer);
+
 #endif
@@ -0,0 +1,16 @@
+#include "AnglePredictor.h"
+
+AnglePredictor::AnglePredictor(float horizon, float duty_gain) : duty_gain_(duty_gain)
+{
+    setHorizon(horizon);
+};
+
+float AnglePredictor::predict(float angle, float angle_rate, float duty)
+{
+    if (horizon_ == 0)
+    {
+        return angle;
+    }
+
+    return angle + (angle_rate + 0.5 * duty_gain_ * duty * horizon_) * horizon_;
+}
@@ -0,0 +1,59 @@
+#include "BatteryMonitor.h"
+#include "InterruptProfiler.h"
+#include <Arduino.h>
+#include <util/atomic.h>
+
+static BatteryMonitor *instance;
+
+ISR(ADC_vect)
+{
+#ifdef INTERRUPT_PROFILER
+    uint8_t start = InterruptProfiler::enter();
+    instance->_onConversion(ADC);
+    InterruptProfiler::leave(InterruptProfiler::VECTOR_ADC, start);
+#else
+    instance->_onConversion(ADC);
+#endif
+}
+
+BatteryMonitor::BatteryMonitor(uint8_t pin, float divider_ratio)
+    : pin_(pin), scale_(divider_ratio * REFERENCE_VOLTAGE / (1023.0 * SAMPLE_COUNT)){};
+
+void BatteryMonitor::begin()
+{
+    instance = this;
+
+    uint8_t channel = pin_ - A0;
+
+    DIDR0 |= 1 << channel;                  // Disable the digital input buffer.
+    ADMUX = (1 << REFS0) | (channel & 0x07); // AVcc reference, right adjusted result.
+
+    // Trigger a conversion on every Timer0 overflow, the millis() interrupt clears the flag so each
+    // overflow starts a new conversion at ~1kHz, far less often than a free running ADC would interrupt.
+    ADCSRB = (1 << ADTS2);
+    ADCSRA = (1 << ADEN) | (1 << ADATE) | (1 << ADIE) | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0);
+}
+
+float BatteryMonitor::getVoltage()
+{
+    uint16_t sum;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        sum = sum_;
+    }
+
+    return sum * scale_;
+}
+
+float BatteryMonitor::getCompensation()
+{
+    float voltage = getVoltage();
+
+    if (voltage < BATTERY_MIN_VOLTAGE)
+    {
+        return 1;
+    }
+
+    return BATTERY_NOMINAL_VOLTAGE / voltage;
+}
@@ -0,0 +1,80 @@
+#include "BiquadFilter.h"
+#include <Arduino.h>
+#include <string.h>
+
+constexpr BiquadFilter::Section BiquadFilter::IDENTITY;
+
+BiquadFilter::BiquadFilter(float scale) : scale_(scale)
+{
+    for (uint8_t i = 0; i < BIQUAD_SECTIONS; i++)
+    {
+        setSection(i, IDENTITY);
+    }
+}
+
+float BiquadFilter::process(float input)
+{
+    if (active_count_ == 0)
+    {
+        return output_ = input;
+    }
+
+    float scaled = constrain(input * scale_, -SAMPLE_LIMIT, SAMPLE_LIMIT);
+    int16_t sample = scaled;
+
+    for (uint8_t i = 0; i < BIQUAD_SECTIONS; i++)
+    {
+        if (!active_[i])
+        {
+            continue;
+        }
+
+        const Section &c = sections_[i];
+        State &s = states_[i];
+
+        // Direct form I, the products are Q2.14 * Q15 and at most 2^28 each.
+        int32_t accumulator = static_cast<int32_t>(c.b0) * sample + static_cast<int32_t>(c.b1) * s.x1 +
+                              static_cast<int32_t>(c.b2) * s.x2 - static_cast<int32_t>(c.a1) * s.y1 -
+                              static_cast<int32_t>(c.a2) * s.y2;
+
+        int16_t output = saturate((accumulator + (1 << 13)) >> 14);
+
+        s.x2 = s.x1;
+        s.x1 = sample;
+        s.y2 = s.y1;
+        s.y1 = output;
+
+        sample = output;
+    }
+
+    return output_ = sample / scale_;
+}
+
+void BiquadFilter::setSection(uint8_t index, const Section &section)
+{
+    sections_[index] = section;
+    active_[index] = memcmp(&section, &IDENTITY, sizeof(Section)) != 0;
+    memset(states_, 0, sizeof(states_));
+
+    active_count_ = 0;
+
+    for (uint8_t i = 0; i < BIQUAD_SECTIONS; i++)
+    {
+        active_count_ += active_[i];
+    }
+}
+
+int16_t BiquadFilter::saturate(int32_t value)
+{
+    if (value > SAMPLE_LIMIT)
+    {
+        return SAMPLE_LIMIT;
+    }
+
+    if (value < -SAMPLE_LIMIT)
+    {
+        return -SAMPLE_LIMIT;
+    }
+
+    return value;
+}
@@ -1,13 +1,34 @@
 #include "CommunicationManager.h"
+#include <Arduino.h>
 #include <HardwareSerial.h>
 
-void CommunicationManager::tick()
+void CommunicationManager::tick(uint32_t budget)
 {
+    uint32_t start = micros();
+    bool served = false;
+
     while (fillBuffer())
     {
+        // Unless the requests are shed, the first packet is served whatever the budget so that the link keeps
+        // making progress. A packet also waits for room for its response in the output, dropping the response would
+        // shift the matching of every later one.
+        bool output_full = stream_->availableForWrite() < static_cast<int>(PACKET_SIZE + 1);
+
+        if (budget == 0 || output_full || (served && micros() - start >= budget))
+        {
+            if (!packet_deferred_)
+            {
+                packet_deferred_ = true;
+                deferred_packets_++;
+            }
+
+            return;
+        }
+
         Packet packet = parsePacket();
         handleRequest(&packet);
         flushBuffer();
+        served = true;
     }
 }
 
@@ -97,6 +118,7 @@ bool CommunicationManager::fillBuffer()
 void CommunicationManager::flushBuffer()
 {
     serial_buffer_size_ = 0;
+    packet_deferred_ = false;
 }
 
 CommunicationManager::Packet CommunicationManager::parsePacket()
@@ -158,7 +180,7 @@ Handler *CommunicationManager::findProperty(char *search)
 
     for (size_t i = 0; i < handlers_size_; i++)
     {
-        if (strcasecmp(handlers_[i].name, search) == 0)
+        if (strcasecmp_P(search, handlers_[i].name) == 0)
         {
             return &handlers_[i];
         }
@@ -167,8 +189,27 @@ Handler *CommunicationManager::findProperty(char *search)
     return nullptr;
 }
 
+void CommunicationManager::stream(const char *data)
+{
+    size_t length = strlen(data);
+
+    // A deferred packet keeps the room for its response.
+    size_t reserved = packet_deferred_ ? PACKET_SIZE + 1 : 0;
+
+    if (stream_->availableForWrite() <= static_cast<int>(length + 1 + reserved))
+    {
+        dropped_packets_++;
+        return;
+    }
+
+    stream_->write(STREAM_PREFIX);
+    stream_->write(data, length);
+    stream_->write(PACKET_DELIMITER);
+}
+
 void CommunicationManager::writePacket(const char *data)
 {
-    stream_->print(data);
-    stream_->print(PACKET_DELIMITER);
+    size_t length = strlen(data);
+    stream_->write(data, length);
+    stream_->write(PACKET_DELIMITER);
 }
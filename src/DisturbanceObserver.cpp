@@ -0,0 +1,52 @@
+#include "DisturbanceObserver.h"
+#include <Arduino.h>
+
+DisturbanceObserver::DisturbanceObserver(float bandwidth, float stiffness, float duty_gain, float max_compensation)
+    : bandwidth_(bandwidth), stiffness_(stiffness), duty_gain_(duty_gain), max_compensation_(max_compensation){};
+
+float DisturbanceObserver::update(float angle, float angle_rate, float duty)
+{
+    if (!enabled_)
+    {
+        return 0;
+    }
+
+    uint32_t now = micros();
+    uint32_t interval = now - last_update_;
+    last_update_ = now;
+
+    if (!primed_ || interval > MAX_UPDATE_INTERVAL)
+    {
+        last_angle_rate_ = angle_rate;
+        primed_ = true;
+        return getCompensation();
+    }
+
+    float dt = interval / 1000000.0;
+    float angle_acceleration = (angle_rate - last_angle_rate_) / dt;
+    last_angle_rate_ = angle_rate;
+
+    // angle_rate' = stiffness * angle + duty_gain * duty + disturbance, the residual is low-passed since
+    // differentiating the rate amplifies the sensor noise.
+    float residual = angle_acceleration - stiffness_ * angle - duty_gain_ * duty;
+    float omega_dt = 2 * M_PI * bandwidth_ * dt;
+    disturbance_ += (residual - disturbance_) * (omega_dt / (1 + omega_dt));
+
+    return getCompensation();
+}
+
+void DisturbanceObserver::reset()
+{
+    primed_ = false;
+    disturbance_ = 0;
+}
+
+float DisturbanceObserver::getCompensation()
+{
+    if (!enabled_ || duty_gain_ == 0)
+    {
+        return 0;
+    }
+
+    return constrain(-disturbance_ / duty_gain_, -max_compensation_, max_compensation_);
+}
@@ -13,10 +13,54 @@ void EEPROMStore::initialize()
 
     EEPROM.put(Address::Version, VERSION);
     EEPROM.put(Address::GyroZeroAngle, GYRO_ZERO_ANGLE);
-    EEPROM.put(Address::BalancePIDkP, BALANCE_PID_KP);
-    EEPROM.put(Address::BalancePIDkI, BALANCE_PID_KI);
-    EEPROM.put(Address::BalancePIDkD, BALANCE_PID_KD);
-    EEPROM.put(Address::VelocityPIDkP, VELOCITY_PID_KP);
-    EEPROM.put(Address::VelocityPIDkI, VELOCITY_PID_KI);
-    EEPROM.put(Address::VelocityPIDkD, VELOCITY_PID_KD);
+    EEPROM.put(Address::BalancePIDDOnRate, BALANCE_PID_D_ON_RATE);
+    EEPROM.put(Address::AnglePredictorHorizon, ANGLE_PREDICTOR_HORIZON);
+    EEPROM.put(Address::AnglePredictorDutyGain, ANGLE_PREDICTOR_DUTY_GAIN);
+    EEPROM.put(Address::PositionPIDkP, POSITION_PID_KP);
+    EEPROM.put(Address::PositionPIDkI, POSITION_PID_KI);
+    EEPROM.put(Address::PositionPIDkD, POSITION_PID_KD);
+    EEPROM.put(Address::GainProfileIndex, static_cast<uint8_t>(0));
+    EEPROM.put(Address::GainScheduleSource, GainScheduler::Source::NONE);
+    EEPROM.put(Address::BatteryCompensation, BATTERY_COMPENSATION);
+    EEPROM.put(Address::GyroOffsetAccel,
+               Gyroscope::Offset{GYRO_OFFSET_ACCEL_X, GYRO_OFFSET_ACCEL_Y, GYRO_OFFSET_ACCEL_Z});
+    EEPROM.put(Address::GyroOffsetGyro, Gyroscope::Offset{GYRO_OFFSET_GYRO_X, GYRO_OFFSET_GYRO_Y, GYRO_OFFSET_GYRO_Z});
+    EEPROM.put(Address::BalancePIDSamplePeriod, static_cast<uint16_t>(BALANCE_PID_SAMPLE_PERIOD));
+    EEPROM.put(Address::VelocityPIDSamplePeriod, static_cast<uint16_t>(VELOCITY_PID_SAMPLE_PERIOD));
+    EEPROM.put(Address::WheelPIDkP, WHEEL_PID_KP);
+    EEPROM.put(Address::WheelPIDkI, WHEEL_PID_KI);
+    EEPROM.put(Address::MotorTrimLeft, MOTOR_TRIM_LEFT);
+    EEPROM.put(Address::MotorTrimRight, MOTOR_TRIM_RIGHT);
+    EEPROM.put(Address::MotionMaxAcceleration, MOTION_MAX_ACCELERATION);
+    EEPROM.put(Address::MotionMaxJerk, MOTION_MAX_JERK);
+    EEPROM.put(Address::MotionFeedforward, MOTION_FEEDFORWARD);
+    EEPROM.put(Address::IdleEnabled, IDLE_ENABLED);
+    EEPROM.put(Address::ObserverEnabled, OBSERVER_ENABLED);
+    EEPROM.put(Address::ObserverBandwidth, OBSERVER_BANDWIDTH);
+    EEPROM.put(Address::ObserverStiffness, OBSERVER_STIFFNESS);
+    EEPROM.put(Address::ObserverDutyGain, OBSERVER_DUTY_GAIN);
+    EEPROM.put(Address::VelocityObserverEnabled, VELOCITY_OBSERVER_ENABLED);
+
+    for (uint8_t filter = 0; filter < BIQUAD_FILTER_COUNT; filter++)
+    {
+        for (uint8_t i = 0; i < BIQUAD_SECTIONS; i++)
+        {
+            setBiquadSection(filter, i, BiquadFilter::IDENTITY);
+        }
+    }
+
+    for (uint8_t i = 0; i < GAIN_PROFILE_COUNT; i++)
+    {
+        GainProfile profile{
+            .breakpoint = static_cast<float>(i),
+            .balance_kp = BALANCE_PID_KP,
+            .balance_ki = BALANCE_PID_KI,
+            .balance_kd = BALANCE_PID_KD,
+            .velocity_kp = VELOCITY_PID_KP,
+            .velocity_ki = VELOCITY_PID_KI,
+            .velocity_kd = VELOCITY_PID_KD,
+        };
+
+        setGainProfile(i, profile);
+    }
 }
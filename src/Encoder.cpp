@@ -1,14 +1,24 @@
 #include "Encoder.h"
 
-#include <PinChangeInterrupt.h>
 #include <util/atomic.h>
 
+#ifndef ENCODER_DIRECT_ISR
+#ifdef INTERRUPT_PROFILER
+#define ISR_HANDLER(n)                                                                                                 \
+    [] {                                                                                                               \
+        uint8_t start = InterruptProfiler::enter();                                                                    \
+        instances[n]->_onPulse();                                                                                      \
+        InterruptProfiler::leave(InterruptProfiler::VECTOR_INT##n, start);                                             \
+    }
+#else
 #define ISR_HANDLER(n) [] { instances[n]->_onPulse(); }
+#endif
 
 typedef void (*Handler)(void);
 
 static Encoder *instances[2];
 static Handler handlers[2] = {ISR_HANDLER(0), ISR_HANDLER(1)};
+#endif
 
 Encoder::Encoder(float sample_time, uint8_t pin_phase_a, uint8_t pin_phase_b, uint8_t fw_level)
     : sample_time_(sample_time), pin_phase_a_(pin_phase_a), pin_phase_b_(pin_phase_b), fw_level_(fw_level)
@@ -18,6 +28,7 @@ Encoder::Encoder(float sample_time, uint8_t pin_phase_a, uint8_t pin_phase_b, ui
     last_sample_ = millis();
 };
 
+#ifndef ENCODER_DIRECT_ISR
 void Encoder::begin()
 {
     pinMode(pin_phase_a_, INPUT_PULLUP);
@@ -27,22 +38,12 @@ void Encoder::begin()
     instances[int_vect] = this;
     attachInterrupt(int_vect, handlers[int_vect], RISING);
 }
+#endif
 
-inline void Encoder::_onPulse()
+void Encoder::_onPulse()
 {
     uint8_t level = (*portInputRegister(port_phase_b_) & bit_phase_b_) != 0;
-    Direction next_direction = level ^ fw_level_ ? Direction::CW : Direction::CCW;
-
-    if (next_direction == direction_)
-    {
-        pulse_count_++;
-    }
-    else
-    {
-        pulse_count_ = 1;
-    }
-
-    direction_ = next_direction;
+    countPulse(level ^ fw_level_);
 }
 
 bool Encoder::tick()
@@ -54,11 +55,20 @@ bool Encoder::tick()
         return false;
     }
 
-    frequency_ = (static_cast<float>(pulse_count_) * (1000.0 / ENCODER_PULSES_PER_REVOLUTION)) / sample_time_;
-    pulse_count_ = 0;
+    uint32_t pulse_count;
+    Direction direction;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        pulse_count = pulse_count_;
+        direction = direction_;
+        pulse_count_ = 0;
+    }
+
+    frequency_ = (static_cast<float>(pulse_count) * (1000.0 / ENCODER_PULSES_PER_REVOLUTION)) / sample_time_;
     last_sample_ = now;
 
-    if (direction_ == Direction::CCW)
+    if (direction == Direction::CCW)
     {
         frequency_ *= -1;
     }
@@ -70,3 +80,29 @@ float Encoder::getFrequency()
 {
     return frequency_;
 }
+
+#ifdef INTERRUPT_PROFILER
+uint32_t Encoder::getMissedPulses()
+{
+    uint32_t missed_pulses;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        missed_pulses = missed_pulses_;
+    }
+
+    return missed_pulses;
+}
+#endif
+
+int32_t Encoder::getPosition()
+{
+    int32_t position;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        position = position_;
+    }
+
+    return position;
+}
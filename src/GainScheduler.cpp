@@ -0,0 +1,101 @@
+#include "GainScheduler.h"
+#include <Arduino.h>
+
+static inline float lerp(float a, float b, float weight)
+{
+    return a + (b - a) * weight;
+}
+
+GainScheduler::GainScheduler(PIDController &balance_loop, PIDController &velocity_loop)
+    : balance_loop_(balance_loop), velocity_loop_(velocity_loop){};
+
+void GainScheduler::select(uint8_t index)
+{
+    selected_ = index;
+    apply();
+}
+
+void GainScheduler::apply()
+{
+    if (source_ != Source::NONE)
+    {
+        point_ = -1;
+        return;
+    }
+
+    const GainProfile &profile = profiles_[selected_];
+
+    balance_loop_.transferTunings(profile.balance_kp, profile.balance_ki, profile.balance_kd);
+    velocity_loop_.transferTunings(profile.velocity_kp, profile.velocity_ki, profile.velocity_kd);
+}
+
+void GainScheduler::setSource(Source source)
+{
+    source_ = source;
+    apply();
+}
+
+void GainScheduler::update(float angle, float speed, float voltage)
+{
+    float value;
+
+    switch (source_)
+    {
+    case Source::ANGLE:
+        value = abs(angle);
+        break;
+    case Source::SPEED:
+        value = abs(speed);
+        break;
+    case Source::VOLTAGE:
+        value = voltage;
+        break;
+    default:
+        return;
+    }
+
+    // Most control steps stay within the applied interpolation step.
+    if (point_ >= 0 && value >= step_min_ && value < step_max_)
+    {
+        return;
+    }
+
+    uint8_t segment = 0;
+
+    while (segment < GAIN_PROFILE_COUNT - 2 && value >= profiles_[segment + 1].breakpoint)
+    {
+        segment++;
+    }
+
+    const GainProfile &low = profiles_[segment];
+    const GainProfile &high = profiles_[segment + 1];
+
+    float span = high.breakpoint - low.breakpoint;
+    float weight = span > 0 ? constrain((value - low.breakpoint) / span, 0, 1) : (value >= high.breakpoint);
+
+    uint8_t step = weight * INTERPOLATION_STEPS + 0.5;
+    int16_t point = segment * (INTERPOLATION_STEPS + 1) + step;
+
+    if (point == point_)
+    {
+        return;
+    }
+
+    point_ = point;
+    weight = static_cast<float>(step) / INTERPOLATION_STEPS;
+
+    // The step covers half a step on each side of its weight, the outer steps reach the breakpoints or beyond.
+    float half_step = span / (2 * INTERPOLATION_STEPS);
+    float value_at_step = lerp(low.breakpoint, high.breakpoint, weight);
+    step_min_ = step > 0 ? value_at_step - half_step : (segment > 0 ? low.breakpoint : -INFINITY);
+    step_max_ = step < INTERPOLATION_STEPS ? value_at_step + half_step
+                                           : (segment < GAIN_PROFILE_COUNT - 2 ? high.breakpoint : INFINITY);
+
+    balance_loop_.transferTunings(lerp(low.balance_kp, high.balance_kp, weight),
+                                  lerp(low.balance_ki, high.balance_ki, weight),
+                                  lerp(low.balance_kd, high.balance_kd, weight));
+
+    velocity_loop_.transferTunings(lerp(low.velocity_kp, high.velocity_kp, weight),
+                                   lerp(low.velocity_ki, high.velocity_ki, weight),
+                                   lerp(low.velocity_kd, high.velocity_kd, weight));
+}
@@ -1,4 +1,4 @@
-#include "gyroscope.h"
+#include "Gyroscope.h"
 #include <MPU6050_6Axis_MotionApps_V6_12.h>
 #include <assert.h>
 
@@ -8,6 +8,94 @@ Gyroscope::Gyroscope(uint8_t address, float zero_angle, Offset offset_accel, Off
     assert(zero_angle <= PI && zero_angle >= -PI);
 };
 
+void Gyroscope::applyOffsets()
+{
+    mpu_.setXAccelOffset(offset_accel_.x);
+    mpu_.setYAccelOffset(offset_accel_.y);
+    mpu_.setZAccelOffset(offset_accel_.z);
+    mpu_.setXGyroOffset(offset_gyro_.x);
+    mpu_.setYGyroOffset(offset_gyro_.y);
+    mpu_.setZGyroOffset(offset_gyro_.z);
+}
+
+void Gyroscope::averageReadings(Offset &accel, Offset &gyro)
+{
+    accel = Offset{0, 0, 0};
+    gyro = Offset{0, 0, 0};
+
+    for (uint16_t i = 0; i < GYRO_CALIBRATION_SAMPLES; i++)
+    {
+        int16_t ax, ay, az, gx, gy, gz;
+        mpu_.getMotion6(&ax, &ay, &az, &gx, &gy, &gz);
+
+        accel.x += ax;
+        accel.y += ay;
+        accel.z += az;
+        gyro.x += gx;
+        gyro.y += gy;
+        gyro.z += gz;
+
+        delay(GYRO_CALIBRATION_SAMPLE_PERIOD);
+    }
+
+    accel.x /= GYRO_CALIBRATION_SAMPLES;
+    accel.y /= GYRO_CALIBRATION_SAMPLES;
+    accel.z /= GYRO_CALIBRATION_SAMPLES;
+    gyro.x /= GYRO_CALIBRATION_SAMPLES;
+    gyro.y /= GYRO_CALIBRATION_SAMPLES;
+    gyro.z /= GYRO_CALIBRATION_SAMPLES;
+}
+
+bool Gyroscope::calibrate(float max_angle, Calibration &calibration)
+{
+    // The offset registers are scaled for the +-1000°/s and +-16g ranges, the readings for the configured ones.
+    uint8_t gyro_scale = 1 << mpu_.getFullScaleGyroRange();
+    uint8_t accel_scale = 1 << mpu_.getFullScaleAccelRange();
+    int32_t one_g = 16384 / accel_scale;
+
+    Offset accel, gyro;
+    averageReadings(accel, gyro);
+
+    // The previous offsets level the readings at the previous balance point, levelling a robot lying on its side would
+    // make it read upright.
+    if (abs(atan2(accel.x, accel.z)) > max_angle)
+    {
+        return false;
+    }
+
+    offset_gyro_.x -= gyro.x * gyro_scale / 4;
+    offset_gyro_.y -= gyro.y * gyro_scale / 4;
+    offset_gyro_.z -= gyro.z * gyro_scale / 4;
+    offset_accel_.x -= accel.x * accel_scale / 8;
+    offset_accel_.y -= accel.y * accel_scale / 8;
+    offset_accel_.z -= (accel.z - one_g) * accel_scale / 8;
+
+    applyOffsets();
+
+    averageReadings(calibration.residual_accel, calibration.residual_gyro);
+
+    // Whatever inclination is left after levelling the accelerometer is the balance point.
+    zero_angle_ = -atan2(calibration.residual_accel.x, calibration.residual_accel.z);
+
+    calibration.residual_accel.z -= one_g;
+    calibration.offset_accel = offset_accel_;
+    calibration.offset_gyro = offset_gyro_;
+    calibration.zero_angle = zero_angle_;
+
+    return true;
+}
+
+float Gyroscope::forwardAcceleration(int16_t accel_x, int16_t accel_z, float sin_pitch, float cos_pitch)
+{
+    // The vertical specific force is taken as 1g, so that the accelerometer scale cancels out.
+    float horizontal = accel_x * cos_pitch - accel_z * sin_pitch;
+    float vertical = accel_x * sin_pitch + accel_z * cos_pitch;
+
+    return vertical > 0 ? GRAVITY * horizontal / vertical : 0;
+}
+
+#ifdef GYRO_RAW_ESTIMATOR
+
 void Gyroscope::begin()
 {
     Wire.begin();
@@ -17,26 +105,243 @@ void Gyroscope::begin()
     mpu_.initialize();
 
     assert(mpu_.testConnection());
-    assert(mpu_.dmpInitialize() == 0);
 
-    mpu_.setXAccelOffset(offset_accel_.x);
-    mpu_.setYAccelOffset(offset_accel_.y);
-    mpu_.setZAccelOffset(offset_accel_.z);
-    mpu_.setXGyroOffset(offset_gyro_.x);
-    mpu_.setYGyroOffset(offset_gyro_.y);
-    mpu_.setZGyroOffset(offset_gyro_.z);
+    mpu_.setFullScaleGyroRange(MPU6050_GYRO_FS_250);
+    mpu_.setFullScaleAccelRange(MPU6050_ACCEL_FS_2);
+    mpu_.setDLPFMode(MPU6050_DLPF_BW_188); // 1kHz gyroscope output rate.
+    mpu_.setRate(0);                       // No sample rate divider.
+
+    applyOffsets();
 
-    mpu_.setDMPEnabled(true);
+    // Start from the accelerometer angle so that the filter does not need to converge.
+    int16_t accel_y;
+    mpu_.getAcceleration(&accel_x_, &accel_y, &accel_z_);
+    angle_ = accelToAngle(accel_x_, accel_z_);
 
-    delay(OUTPUT_STABILIZATION_DELAY);
+    last_sample_ = micros();
+    sample_period_ = GYRO_RAW_ESTIMATOR_PERIOD / 1000.0;
 }
 
-void Gyroscope::tick()
+bool Gyroscope::tick()
 {
-    if (mpu_.dmpPacketAvailable())
+    uint32_t now = micros();
+    uint32_t elapsed = now - last_sample_;
+
+    if (elapsed < GYRO_RAW_ESTIMATOR_PERIOD)
+    {
+        return false;
+    }
+
+    uint32_t samples = elapsed / GYRO_RAW_ESTIMATOR_PERIOD;
+
+    if (samples > MAX_MISSED_SAMPLES)
     {
-        mpu_.dmpGetCurrentFIFOPacket(fifo_buffer_);
+        samples = MAX_MISSED_SAMPLES;
+        last_sample_ = now;
     }
+    else
+    {
+        last_sample_ += samples * GYRO_RAW_ESTIMATOR_PERIOD;
+    }
+
+    // The pitch is measured around the negative Y axis, see MPU6050::dmpGetYawPitchRoll.
+    angle_rate_ = -mpu_.getRotationY();
+    angle_ = wrapAngle(angle_ + static_cast<int32_t>(angle_rate_) * samples);
+
+    accel_samples_ += samples;
+
+    if (accel_samples_ < GYRO_RAW_ESTIMATOR_ACCEL_DECIMATION)
+    {
+        return true;
+    }
+
+    accel_samples_ = 0;
+
+    int16_t accel_y;
+    mpu_.getAcceleration(&accel_x_, &accel_y, &accel_z_);
+
+    int32_t error = wrapAngle(accelToAngle(accel_x_, accel_z_) - angle_);
+    angle_ = wrapAngle(angle_ + (error >> GYRO_RAW_ESTIMATOR_ACCEL_SHIFT));
+
+    return true;
+}
+
+float Gyroscope::getAngle()
+{
+    float pitch = angle_ / ANGLE_UNITS_PER_RAD + zero_angle_;
+
+    if (pitch < -PI)
+    {
+        return 2 * PI + pitch;
+    }
+
+    if (pitch > PI)
+    {
+        return -2 * PI + pitch;
+    }
+
+    return pitch;
+}
+
+float Gyroscope::getAngleRate()
+{
+    return angle_rate_ / GYRO_SENSITIVITY;
+}
+
+float Gyroscope::getForwardAcceleration()
+{
+    float pitch = angle_ / ANGLE_UNITS_PER_RAD;
+    return forwardAcceleration(accel_x_, accel_z_, sin(pitch), cos(pitch));
+}
+
+int32_t Gyroscope::accelToAngle(int16_t accel_x, int16_t accel_z)
+{
+    return atan2(accel_x, accel_z) * ANGLE_UNITS_PER_RAD;
+}
+
+int32_t Gyroscope::wrapAngle(int32_t angle)
+{
+    if (angle > ANGLE_UNITS_PI)
+    {
+        return angle - 2 * ANGLE_UNITS_PI;
+    }
+
+    if (angle < -ANGLE_UNITS_PI)
+    {
+        return angle + 2 * ANGLE_UNITS_PI;
+    }
+
+    return angle;
+}
+
+#else
+
+void Gyroscope::begin()
+{
+    Wire.begin();
+    Wire.setClock(400000);
+    Wire.setWireTimeout(3000, true);
+
+    assert(mpu_.testConnection());
+
+    // The sensor is not reset along with the MCU, after a watchdog or brownout reset it is still running.
+    warm_start_ = isConfigured();
+
+    if (warm_start_)
+    {
+        mpu_.resetFIFO();
+    }
+    else
+    {
+        mpu_.initialize();
+
+        assert(mpu_.dmpInitialize() == 0);
+
+        applyOffsets();
+
+        mpu_.setDMPEnabled(true);
+    }
+
+    waitConvergence();
+}
+
+bool Gyroscope::isConfigured()
+{
+    if (!mpu_.getDMPEnabled())
+    {
+        return false;
+    }
+
+    if (mpu_.getXAccelOffset() != offset_accel_.x || mpu_.getYAccelOffset() != offset_accel_.y ||
+        mpu_.getZAccelOffset() != offset_accel_.z || mpu_.getXGyroOffset() != offset_gyro_.x ||
+        mpu_.getYGyroOffset() != offset_gyro_.y || mpu_.getZGyroOffset() != offset_gyro_.z)
+    {
+        return false;
+    }
+
+    // Compare the tail of the firmware, which would not have been written if an upload was interrupted.
+    static const uint16_t check_offset = MPU6050_DMP_CODE_SIZE - FIRMWARE_CHECK_SIZE;
+    static_assert(check_offset % 256 + FIRMWARE_CHECK_SIZE <= 256, "The firmware check must not cross a memory bank.");
+
+    uint8_t firmware[FIRMWARE_CHECK_SIZE];
+    mpu_.readMemoryBlock(firmware, FIRMWARE_CHECK_SIZE, check_offset / 256, check_offset % 256);
+
+    for (uint8_t i = 0; i < FIRMWARE_CHECK_SIZE; i++)
+    {
+        if (firmware[i] != pgm_read_byte(dmpMemory + check_offset + i))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void Gyroscope::waitConvergence()
+{
+    uint32_t start = millis();
+    float last_angle = NAN;
+    uint8_t settled_samples = 0;
+
+    // The DMP output rate depends on its firmware, it is measured while polling for the samples.
+    uint32_t first_sample = 0, last_sample = 0;
+    uint16_t samples = 0;
+
+    while (millis() - start < OUTPUT_STABILIZATION_DELAY && settled_samples < GYRO_CONVERGENCE_SAMPLES)
+    {
+        if (!tick())
+        {
+            continue;
+        }
+
+        last_sample = micros();
+        if (samples++ == 0) first_sample = last_sample;
+
+        float angle = getAngle();
+
+        if (abs(angle - last_angle) < GYRO_CONVERGENCE_TOLERANCE)
+        {
+            settled_samples++;
+        }
+        else
+        {
+            settled_samples = 0;
+        }
+
+        last_angle = angle;
+    }
+
+    sample_period_ = samples > 1 ? (last_sample - first_sample) / 1000.0 / (samples - 1) : 0;
+}
+
+bool Gyroscope::tick()
+{
+    uint16_t count = mpu_.getFIFOCount();
+
+    if (count < PACKET_SIZE)
+    {
+        return false;
+    }
+
+    // A full FIFO has dropped bytes and lost the packet alignment.
+    if (count >= FIFO_SIZE - PACKET_SIZE)
+    {
+        mpu_.resetFIFO();
+        return false;
+    }
+
+    // Only the latest complete packet is of interest, a partial one is still being written by the DMP.
+    for (; count >= PACKET_SIZE; count -= PACKET_SIZE)
+    {
+        mpu_.getFIFOBytes(fifo_buffer_, PACKET_SIZE);
+    }
+
+    return true;
+}
+
+void Gyroscope::_loadPacket(const uint8_t *packet)
+{
+    memcpy(fifo_buffer_, packet, PACKET_SIZE);
 }
 
 float Gyroscope::getAngle()
@@ -63,3 +368,29 @@ float Gyroscope::getAngle()
 
     return pitch;
 }
+
+float Gyroscope::getAngleRate()
+{
+    int16_t gyro[3];
+    mpu_.dmpGetGyro(gyro, fifo_buffer_);
+
+    // The pitch is measured around the negative Y axis, see MPU6050::dmpGetYawPitchRoll.
+    return -gyro[1] / GYRO_SENSITIVITY;
+}
+
+float Gyroscope::getForwardAcceleration()
+{
+    Quaternion quaternion;
+    VectorFloat gravity;
+    VectorInt16 accel;
+
+    mpu_.dmpGetQuaternion(&quaternion, fifo_buffer_);
+    mpu_.dmpGetGravity(&gravity, &quaternion);
+    mpu_.dmpGetAccel(&accel, fifo_buffer_);
+
+    // Same pitch as MPU6050::dmpGetYawPitchRoll, from the gravity direction.
+    float cos_pitch = sqrt(gravity.y * gravity.y + gravity.z * gravity.z);
+    return forwardAcceleration(accel.x, accel.z, gravity.x, cos_pitch);
+}
+
+#endif
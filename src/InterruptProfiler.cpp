@@ -0,0 +1,57 @@
+#include "InterruptProfiler.h"
+#include "configuration.h"
+#include <util/atomic.h>
+
+#ifdef INTERRUPT_PROFILER
+
+InterruptProfiler::Stats InterruptProfiler::stats_[VECTOR_COUNT];
+volatile uint16_t InterruptProfiler::max_blocked_ = 0;
+
+ISR(TIMER1_OVF_vect)
+{
+    InterruptProfiler::_onLatencySample();
+}
+
+void InterruptProfiler::begin()
+{
+    TCCR2A = 0;           // Normal mode, TOP = 0xFF.
+    TCCR2B = 1 << CS21;   // clk/8.
+    TIMSK1 |= 1 << TOIE1; // Sample the latency on each Timer1 overflow.
+
+    reset();
+}
+
+void InterruptProfiler::reset()
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        memset(stats_, 0, sizeof(stats_));
+        max_blocked_ = 0;
+    }
+}
+
+InterruptProfiler::Stats InterruptProfiler::getStats(Vector vector)
+{
+    Stats stats;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        stats = stats_[vector];
+    }
+
+    return stats;
+}
+
+uint16_t InterruptProfiler::getMaxBlocked()
+{
+    uint16_t max_blocked;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        max_blocked = max_blocked_;
+    }
+
+    return max_blocked;
+}
+
+#endif
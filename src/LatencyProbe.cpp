@@ -0,0 +1,126 @@
+#include "LatencyProbe.h"
+#include <Arduino.h>
+
+void LatencyProbe::begin()
+{
+#ifdef LATENCY_PROBE_PIN
+    pinMode(LATENCY_PROBE_PIN, OUTPUT);
+    digitalWrite(LATENCY_PROBE_PIN, LOW);
+#endif
+
+    reset();
+}
+
+void LatencyProbe::mark(Stage stage)
+{
+    uint32_t now = micros();
+    timestamps_[stage] = now;
+
+#ifdef LATENCY_PROBE_PIN
+    if (stage == SAMPLE)
+    {
+        digitalWrite(LATENCY_PROBE_PIN, HIGH);
+    }
+    else if (stage == ACTUATION)
+    {
+        digitalWrite(LATENCY_PROBE_PIN, LOW);
+    }
+#endif
+
+    if (stage != ACTUATION)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < STAGE_COUNT; i++)
+    {
+        delays_[i] = timestamps_[i] - timestamps_[SAMPLE];
+    }
+
+    record(delays_[ACTUATION]);
+}
+
+void LatencyProbe::reset()
+{
+    min_ = UINT32_MAX;
+    max_ = 0;
+    sum_ = 0;
+    count_ = 0;
+
+    memset(histogram_, 0, sizeof(histogram_));
+    memset(delays_, 0, sizeof(delays_));
+}
+
+void LatencyProbe::record(uint32_t latency)
+{
+    // Halve the statistics before they overflow so that they keep tracking the distribution.
+    if (count_ == UINT16_MAX)
+    {
+        sum_ /= 2;
+        count_ /= 2;
+
+        for (size_t i = 0; i < HISTOGRAM_LEN; i++)
+        {
+            histogram_[i] /= 2;
+        }
+    }
+
+    size_t bucket = latency / LATENCY_PROBE_BUCKET_WIDTH;
+
+    if (bucket >= HISTOGRAM_LEN)
+    {
+        bucket = HISTOGRAM_LEN - 1;
+    }
+
+    histogram_[bucket]++;
+    count_++;
+    sum_ += latency;
+
+    if (latency < min_)
+    {
+        min_ = latency;
+    }
+
+    if (latency > max_)
+    {
+        max_ = latency;
+    }
+}
+
+uint32_t LatencyProbe::getMin()
+{
+    return count_ > 0 ? min_ : 0;
+}
+
+uint32_t LatencyProbe::getMean()
+{
+    return count_ > 0 ? sum_ / count_ : 0;
+}
+
+uint32_t LatencyProbe::getMax()
+{
+    return max_;
+}
+
+uint32_t LatencyProbe::getPercentile99()
+{
+    uint32_t threshold = count_ - count_ / 100;
+    uint32_t cumulative = 0;
+
+    for (size_t i = 0; i < HISTOGRAM_LEN - 1; i++)
+    {
+        cumulative += histogram_[i];
+
+        if (cumulative >= threshold)
+        {
+            return min(static_cast<uint32_t>((i + 1) * LATENCY_PROBE_BUCKET_WIDTH), max_);
+        }
+    }
+
+    return max_;
+}
+
+uint32_t LatencyProbe::getStageDelay(Stage stage)
+{
+    return delays_[stage];
+}
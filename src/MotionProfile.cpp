@@ -0,0 +1,84 @@
+#include "MotionProfile.h"
+#include <Arduino.h>
+
+MotionProfile::MotionProfile(float sample_time, float max_acceleration, float max_jerk, float travel_per_revolution,
+                             float max_lean)
+    : sample_time_(sample_time), max_acceleration_(max_acceleration), max_jerk_(max_jerk),
+      travel_per_revolution_(travel_per_revolution), max_lean_(max_lean){};
+
+bool MotionProfile::tick()
+{
+    uint32_t now = millis();
+    uint32_t elapsed = now - last_sample_;
+
+    if (elapsed < sample_time_)
+    {
+        return false;
+    }
+
+    last_sample_ = now;
+
+    // A late sample advances by one period, so a stalled loop delays the trajectory instead of jumping it.
+    float dt = min(elapsed, static_cast<uint32_t>(sample_time_)) / 1000.0;
+    float error = target_ - speed_;
+
+    if (max_acceleration_ <= 0)
+    {
+        speed_ = target_;
+        acceleration_ = 0;
+        return true;
+    }
+
+    // Largest acceleration that can still be ramped down to zero by the jerk limit before reaching the target.
+    float acceleration = max_acceleration_;
+
+    if (max_jerk_ > 0)
+    {
+        acceleration = min(acceleration, sqrt(2 * max_jerk_ * abs(error)));
+    }
+
+    acceleration = error < 0 ? -acceleration : acceleration;
+
+    if (max_jerk_ > 0)
+    {
+        float max_step = max_jerk_ * dt;
+        acceleration_ += constrain(acceleration - acceleration_, -max_step, max_step);
+    }
+    else
+    {
+        acceleration_ = acceleration;
+    }
+
+    float step = acceleration_ * dt;
+
+    // Land on the target rather than dithering around it by less than one step.
+    if ((error >= 0 && step >= error) || (error <= 0 && step <= error))
+    {
+        speed_ = target_;
+        acceleration_ = 0;
+    }
+    else
+    {
+        speed_ += step;
+    }
+
+    return true;
+}
+
+void MotionProfile::reset()
+{
+    speed_ = 0;
+    acceleration_ = 0;
+}
+
+float MotionProfile::getLean()
+{
+    if (!feedforward_)
+    {
+        return 0;
+    }
+
+    // The velocity loop is reversed, leaning to negative angles accelerates forward.
+    float lean = -atan(acceleration_ * travel_per_revolution_ / GRAVITY);
+    return constrain(lean, -max_lean_, max_lean_);
+}
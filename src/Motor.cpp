@@ -50,3 +50,10 @@ void Motor::setDuty(int8_t duty)
         digitalWrite(pin_fw_, LOW);
     }
 }
+
+void Motor::coast()
+{
+    // A zero duty still drives a minimal pulse forward, both inputs low leave the motor disconnected.
+    digitalWrite(pin_fw_, LOW);
+    digitalWrite(pin_bw_, LOW);
+}
@@ -0,0 +1,21 @@
+#include "Odometry.h"
+
+Odometry::Odometry(float travel_per_pulse, float wheel_base)
+    : travel_per_pulse_(travel_per_pulse), wheel_base_(wheel_base){};
+
+void Odometry::update(int32_t position_l, int32_t position_r)
+{
+    position_l_ = position_l;
+    position_r_ = position_r;
+}
+
+float Odometry::getDistance()
+{
+    // Sum before converting so that the count does not lose precision as the distance grows.
+    return static_cast<float>(position_l_ + position_r_) * (travel_per_pulse_ / 2);
+}
+
+float Odometry::getHeading()
+{
+    return static_cast<float>(position_r_ - position_l_) * (travel_per_pulse_ / wheel_base_);
+}
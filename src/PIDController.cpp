@@ -1,8 +1,59 @@
 #include "PIDController.h"
+#include <Arduino.h>
 
 PIDController::PIDController(float sample_period, float output_min, float output_max, bool direct)
-    : PID((double *)&input_, (double *)&output_, (double *)&setpoint_, 0, 0, 0, direct ? DIRECT : REVERSE)
+    : PID((double *)&input_, (double *)&output_, (double *)&setpoint_, 0, 0, 0, direct ? DIRECT : REVERSE),
+      output_min_(output_min), output_max_(output_max), direct_(direct), sample_period_(sample_period)
 {
     SetOutputLimits(output_min, output_max);
     SetSampleTime(sample_period);
 };
+
+void PIDController::transferTunings(float kp, float ki, float kd)
+{
+    setTunings(kp, ki, kd);
+
+    if (GetMode() != AUTOMATIC)
+    {
+        return;
+    }
+
+    // The PID library loads the integral sum from the output when switching to automatic mode,
+    // preload it so that the next proportional term adds back up to the current output. The next computation also
+    // subtracts the rate derivative term, which the output already has subtracted.
+    float output = output_;
+    float proportional = (direct_ ? kp : -kp) * (setpoint_ - input_);
+    float derivative = derivative_on_rate_ ? (direct_ ? kd : -kd) * input_rate_ : 0;
+
+    output_ = output - proportional + derivative;
+    SetMode(MANUAL);
+    SetMode(AUTOMATIC);
+    output_ = output;
+}
+
+bool PIDController::compute(float input, float input_rate)
+{
+    if (!derivative_on_rate_)
+    {
+        return compute(input);
+    }
+
+    // The library clamps its proportional and integral sum, shifting its limits by the derivative term clamps the
+    // complete output once the derivative is subtracted and bounds the integral sum against it too. Shifting them
+    // also clamps the held output, which is restored when no sample is due.
+    float derivative = direct_ ? kd_ * input_rate : -kd_ * input_rate;
+    float output = output_;
+
+    input_ = input;
+    SetOutputLimits(output_min_ + derivative, output_max_ + derivative);
+
+    if (!PID::Compute())
+    {
+        output_ = output;
+        return false;
+    }
+
+    input_rate_ = input_rate;
+    output_ -= derivative;
+    return true;
+}
@@ -0,0 +1,39 @@
+#include "SystemIdentifier.h"
+
+SystemIdentifier::SystemIdentifier(uint8_t amplitude, uint8_t bit_period)
+    : amplitude_(amplitude), bit_period_(bit_period)
+{
+}
+
+void SystemIdentifier::enable()
+{
+    lfsr_ = LFSR_SEED;
+    bit_samples_ = 0;
+    sample_ = 0;
+    enabled_ = true;
+}
+
+void SystemIdentifier::disable()
+{
+    enabled_ = false;
+}
+
+int16_t SystemIdentifier::next()
+{
+    if (!enabled_)
+    {
+        return 0;
+    }
+
+    // 9 bit maximal length sequence, taps 9 and 5, repeats every 511 bits.
+    if (++bit_samples_ >= bit_period_)
+    {
+        bit_samples_ = 0;
+        uint16_t bit = ((lfsr_ >> 8) ^ (lfsr_ >> 4)) & 1;
+        lfsr_ = ((lfsr_ << 1) | bit) & 0x1FF;
+    }
+
+    sample_++;
+
+    return lfsr_ & 1 ? amplitude_ : -static_cast<int16_t>(amplitude_);
+}
@@ -0,0 +1,44 @@
+#include "VelocityObserver.h"
+#include <Arduino.h>
+
+VelocityObserver::VelocityObserver(float travel_per_revolution, uint8_t gain_shift, uint8_t bias_shift)
+    : acceleration_scale_(ONE / travel_per_revolution), gain_shift_(gain_shift), bias_shift_(bias_shift){};
+
+void VelocityObserver::predict(float acceleration)
+{
+    uint32_t now = micros();
+    uint32_t interval = min(now - last_predict_, MAX_PREDICT_INTERVAL);
+    last_predict_ = now;
+
+    // Within the int32 range up to about 140 m/s^2, well beyond the accelerometer range.
+    int32_t corrected = static_cast<int32_t>(acceleration * acceleration_scale_) - bias_;
+    speed_ += (static_cast<int64_t>(corrected) * (interval * SECONDS_PER_US_Q32)) >> 32;
+}
+
+void VelocityObserver::correct(float speed)
+{
+    int32_t measured = speed * ONE;
+
+    // The encoders average the speed over their window, which for a steady acceleration is the mean of the
+    // estimates at both ends of it.
+    int32_t innovation = measured - (window_start_ / 2 + speed_ / 2);
+
+    speed_ += innovation >> gain_shift_;
+
+    // An accelerometer bias drifts the estimate by bias * window over the window, by half of that on average.
+    bias_ -= static_cast<int32_t>(innovation * bias_rate_) >> bias_shift_;
+    window_start_ = speed_;
+}
+
+void VelocityObserver::setWindow(uint16_t period)
+{
+    bias_rate_ = 2000.0 / period;
+}
+
+void VelocityObserver::reset(float speed)
+{
+    speed_ = speed * ONE;
+    bias_ = 0;
+    window_start_ = speed_;
+    last_predict_ = micros();
+}
@@ -1,7 +1,8 @@
+#include "configuration.h"
 #include <Arduino.h>
 #include <assert.h>
 
-static const uint32_t SERIAL_FALLBACK_FREQUENCY = 9600;
+static const uint32_t SERIAL_FALLBACK_FREQUENCY = SERIAL_BAUD_RATE;
 static const uint32_t BLINK_DELAY = 500;
 
 void __assert(const char *__func, const char *__file, int __lineno, const char *__sexp)
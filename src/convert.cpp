@@ -1,28 +1,170 @@
 #include "convert.h"
 #include <ctype.h>
-#include <errno.h>
 #include <math.h>
-#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+/// Largest mantissa that can take one more decimal digit without overflowing.
+static const uint32_t MAX_MANTISSA = (UINT32_MAX - 9) / 10;
+
+/// Largest decimal exponent that fits a float.
+static const int8_t MAX_EXPONENT = 38;
+
+/// Largest number of decimals that can be scaled by scaleByPowerOfTen.
+static const int8_t MAX_DECIMALS = 63;
+
+/// Largest number of decimals printed by doubleToString.
+static const uint8_t MAX_PRECISION = 9;
+
+/// Multiply the value by ten to the given power, in at most seven multiplications or divisions.
+static float scaleByPowerOfTen(float value, int8_t exponent)
+{
+    static const float POWERS[] = {1e1, 1e2, 1e4, 1e8, 1e16, 1e32};
+
+    bool negative = exponent < 0;
+    uint8_t magnitude = negative ? -exponent : exponent;
+    float scale = 1;
+
+    // A scale past 1e38 overflows, the largest power is applied on its own so that small results reach subnormals.
+    if (magnitude >= 32)
+    {
+        value = negative ? value / POWERS[5] : value * POWERS[5];
+        magnitude -= 32;
+    }
+
+    for (uint8_t i = 0; magnitude != 0; i++, magnitude >>= 1)
+    {
+        if (magnitude & 1)
+        {
+            scale *= POWERS[i];
+        }
+    }
+
+    return negative ? value / scale : value * scale;
+}
 
 double stringToDouble(char *s)
 {
-    char *endptr;
-    errno = 0;
+    for (; isspace((unsigned char)*s); s++)
+        ;
 
-    double result = strtod(s, &endptr);
+    bool negative = *s == '-';
 
-    if (s == endptr || errno != 0)
+    if (*s == '-' || *s == '+')
     {
-        return NAN;
+        s++;
+    }
+
+    uint32_t mantissa = 0;
+    int16_t exponent = 0;
+    bool has_digits = false;
+    bool has_point = false;
+
+    for (;; s++)
+    {
+        if (isdigit((unsigned char)*s))
+        {
+            has_digits = true;
+
+            if (mantissa <= MAX_MANTISSA)
+            {
+                mantissa = mantissa * 10 + (*s - '0');
+                exponent -= has_point;
+            }
+            else
+            {
+                // Digits beyond the mantissa precision are dropped, integer ones still scale the result.
+                exponent += !has_point;
+            }
+        }
+        else if (*s == '.' && !has_point)
+        {
+            has_point = true;
+        }
+        else
+        {
+            break;
+        }
     }
 
-    for (; isspace((unsigned char)*endptr); endptr++)
+    for (; isspace((unsigned char)*s); s++)
         ;
 
-    if (*endptr)
+    if (!has_digits || *s || exponent > MAX_EXPONENT)
     {
         return NAN;
     }
 
-    return result;
+    float result = exponent < -MAX_DECIMALS ? 0 : scaleByPowerOfTen(mantissa, exponent);
+
+    if (isinf(result))
+    {
+        return NAN;
+    }
+
+    return negative ? -result : result;
+}
+
+char *doubleToString(double value, uint8_t precision, char *buffer)
+{
+    char *p = buffer;
+
+    if (isnan(value))
+    {
+        strcpy(buffer, "nan");
+        return buffer;
+    }
+
+    if (value < 0)
+    {
+        *p++ = '-';
+        value = -value;
+    }
+
+    if (precision > MAX_PRECISION)
+    {
+        precision = MAX_PRECISION;
+    }
+
+    value += scaleByPowerOfTen(0.5, -precision);
+
+    if (value >= UINT32_MAX)
+    {
+        strcpy(buffer, "ovf");
+        return buffer;
+    }
+
+    uint32_t integer = value;
+    float fraction = value - integer;
+
+    char digits[10];
+    uint8_t count = 0;
+
+    do
+    {
+        digits[count++] = '0' + integer % 10;
+        integer /= 10;
+    } while (integer != 0);
+
+    while (count > 0)
+    {
+        *p++ = digits[--count];
+    }
+
+    if (precision > 0)
+    {
+        *p++ = '.';
+    }
+
+    for (; precision > 0; precision--)
+    {
+        fraction *= 10;
+        uint8_t digit = fraction;
+        fraction -= digit;
+        *p++ = '0' + digit;
+    }
+
+    *p = '\0';
+
+    return buffer;
 }
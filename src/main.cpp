@@ -1,12 +1,25 @@
+#include "AnglePredictor.h"
+#include "BatteryMonitor.h"
+#include "BiquadFilter.h"
 #include "CommunicationManager.h"
+#include "DisturbanceObserver.h"
 #include "EEPROMStore.h"
 #include "Encoder.h"
+#include "GainScheduler.h"
 #include "Gyroscope.h"
+#include "InterruptProfiler.h"
+#include "LatencyProbe.h"
+#include "MotionProfile.h"
 #include "Motor.h"
+#include "Odometry.h"
 #include "PIDController.h"
+#include "Pipeline.h"
+#include "SystemIdentifier.h"
+#include "VelocityObserver.h"
 #include "configuration.h"
 #include "convert.h"
 #include <Arduino.h>
+#include <avr/sleep.h>
 
 static const constexpr float MAX_LEAN_ANGLE_RAD = (MAX_LEAN_ANGLE * M_PI) / 180.0;
 static const constexpr float STARTUP_ANGLE_RAD = (STARTUP_ANGLE * M_PI) / 180.0;
@@ -22,189 +35,1627 @@ Gyroscope gyroscope(GYRO_ADDRESS,
 Motor motor_left(PIN_MOTOR_L_FW, PIN_MOTOR_L_BW);
 Motor motor_right(PIN_MOTOR_R_FW, PIN_MOTOR_R_BW);
 
+#ifdef ENCODER_DIRECT_ISR
+DirectEncoder<PIN_ENCODER_L_A, PIN_ENCODER_L_B, PIN_ENCODER_L_FW_LEVEL> encoder_left(ENCODER_SAMPLE_PERIOD);
+DirectEncoder<PIN_ENCODER_R_A, PIN_ENCODER_R_B, PIN_ENCODER_R_FW_LEVEL> encoder_right(ENCODER_SAMPLE_PERIOD);
+
+static_assert(decltype(encoder_left)::INTERRUPT != decltype(encoder_right)::INTERRUPT,
+              "The encoders must use different external interrupts.");
+
+// The branches are resolved at compile time, each vector calls straight into its encoder.
+ISR(INT0_vect)
+{
+    if (decltype(encoder_left)::INTERRUPT == 0)
+    {
+        encoder_left._onInterrupt();
+    }
+    else
+    {
+        encoder_right._onInterrupt();
+    }
+}
+
+ISR(INT1_vect)
+{
+    if (decltype(encoder_left)::INTERRUPT == 1)
+    {
+        encoder_left._onInterrupt();
+    }
+    else
+    {
+        encoder_right._onInterrupt();
+    }
+}
+#else
 Encoder encoder_left(ENCODER_SAMPLE_PERIOD, PIN_ENCODER_L_A, PIN_ENCODER_L_B, PIN_ENCODER_L_FW_LEVEL);
 Encoder encoder_right(ENCODER_SAMPLE_PERIOD, PIN_ENCODER_R_A, PIN_ENCODER_R_B, PIN_ENCODER_R_FW_LEVEL);
+#endif
+
+BatteryMonitor battery_monitor(PIN_BATTERY, BATTERY_DIVIDER_RATIO);
+bool battery_compensation = false;
+
+/// Whether the low power idle mode may be entered, and whether it currently is.
+bool idle_enabled = IDLE_ENABLED;
+bool idle_active = false;
+
+Odometry odometry(WHEEL_TRAVEL_PER_REVOLUTION / ENCODER_PULSES_PER_REVOLUTION, WHEEL_BASE);
 
 CommunicationManager comm_manager;
 
+/// Serial link rate to switch to once the pending responses have been sent, zero if none. Nothing is streamed meanwhile
+/// so that the transmitter drains.
+uint32_t pending_baud_rate = 0;
+
+/// [us] Time budget for processing serial requests in each loop cycle.
+uint32_t comm_tick_budget = COMM_TICK_BUDGET;
+
+/// [us] Duration of the last loop cycle.
+uint32_t loop_duration = 0;
+
+/// Number of loop cycles that took longer than the balance loop sample period.
+uint32_t loop_overruns = 0;
+
+/// Number of consecutive loop cycles that shed the serial requests.
+uint8_t shed_cycles = 0;
+
+/// [ms] Duration of the boot phases.
+struct BootTimes
+{
+    uint32_t eeprom, serial, gyroscope, total;
+} boot_times;
+
+#ifdef LATENCY_PROBE
+LatencyProbe latency_probe;
+#endif
+
 PIDController balance_loop(BALANCE_PID_SAMPLE_PERIOD, static_cast<double>(INT8_MIN), static_cast<double>(INT8_MAX));
 PIDController velocity_loop(VELOCITY_PID_SAMPLE_PERIOD, -MAX_WORKING_ANGLE_RAD, MAX_WORKING_ANGLE_RAD, false);
 
-Handler handlers[] = {
+GainScheduler gain_scheduler(balance_loop, velocity_loop);
+
+PIDController position_loop(POSITION_PID_SAMPLE_PERIOD, -POSITION_PID_MAX_SPEED, POSITION_PID_MAX_SPEED);
+bool position_hold = false;
+
+MotionProfile motion_profile(BALANCE_PID_SAMPLE_PERIOD, MOTION_MAX_ACCELERATION, MOTION_MAX_JERK,
+                             WHEEL_TRAVEL_PER_REVOLUTION, MAX_WORKING_ANGLE_RAD);
+
+PIDController wheel_loop_left(VELOCITY_PID_SAMPLE_PERIOD, -WHEEL_PID_MAX_DUTY, WHEEL_PID_MAX_DUTY);
+PIDController wheel_loop_right(VELOCITY_PID_SAMPLE_PERIOD, -WHEEL_PID_MAX_DUTY, WHEEL_PID_MAX_DUTY);
+
+/// [rev/s] Requested left wheel speed minus right wheel speed.
+float steering = 0;
+
+/// Gains applied to the balance loop output on each motor.
+float motor_trim_left = MOTOR_TRIM_LEFT, motor_trim_right = MOTOR_TRIM_RIGHT;
+
+AnglePredictor angle_predictor(ANGLE_PREDICTOR_HORIZON, ANGLE_PREDICTOR_DUTY_GAIN);
+
+DisturbanceObserver disturbance_observer(OBSERVER_BANDWIDTH, OBSERVER_STIFFNESS, OBSERVER_DUTY_GAIN, OBSERVER_MAX_DUTY);
+
+SystemIdentifier system_identifier(SYSID_AMPLITUDE, SYSID_BIT_PERIOD);
+
+/// Filters in the order of their sections in EEPROM.
+enum FilterIndex : uint8_t
+{
+    FILTER_ANGLE,
+    FILTER_VELOCITY,
+    FILTER_DUTY,
+};
+
+BiquadFilter filters[] = {
+    BiquadFilter(FILTER_ANGLE_SCALE),
+    BiquadFilter(FILTER_VELOCITY_SCALE),
+    BiquadFilter(FILTER_DUTY_SCALE),
+};
+
+static_assert(sizeof(filters) / sizeof(filters[0]) == EEPROMStore::BIQUAD_FILTER_COUNT,
+              "Every filter needs its sections in EEPROM.");
+
+/// Filter section edited by the filter properties.
+uint8_t filter_section = 0;
+
+VelocityObserver velocity_observer(WHEEL_TRAVEL_PER_REVOLUTION, VELOCITY_OBSERVER_GAIN_SHIFT,
+                                   VELOCITY_OBSERVER_BIAS_SHIFT);
+
+/// [ms] Apply the loop sample periods, the position hold loop follows the velocity loop.
+/// The encoders and the wheel loops follow it too, unless the velocity observer fills in between encoder samples.
+void setLoopPeriods(uint16_t balance_period, uint16_t velocity_period)
+{
+    uint16_t encoder_period = velocity_period;
+
+    if (velocity_observer.isEnabled() && encoder_period < ENCODER_SAMPLE_PERIOD)
+    {
+        encoder_period = ENCODER_SAMPLE_PERIOD;
+    }
+
+    balance_loop.setSamplePeriod(balance_period);
+    motion_profile.setSampleTime(balance_period);
+    velocity_loop.setSamplePeriod(velocity_period);
+    position_loop.setSamplePeriod(velocity_period);
+    wheel_loop_left.setSamplePeriod(encoder_period);
+    wheel_loop_right.setSamplePeriod(encoder_period);
+    encoder_left.setSampleTime(encoder_period);
+    encoder_right.setSampleTime(encoder_period);
+    velocity_observer.setWindow(encoder_period);
+}
+
+/// Whether the periods are whole milliseconds, the balance loop would get a new sample every cycle and outlast the
+/// loop cycle, and the velocity loop runs every few balance cycles, no faster than the encoders sample unless the
+/// velocity observer fills in between their samples.
+bool validLoopPeriods(double balance_period, double velocity_period)
+{
+    if (isnan(balance_period) || isnan(velocity_period)) return false;
+    if (balance_period != static_cast<uint16_t>(balance_period)) return false;
+    if (velocity_period != static_cast<uint16_t>(velocity_period)) return false;
+    if (balance_period < BALANCE_PID_MIN_SAMPLE_PERIOD || balance_period < gyroscope.getSamplePeriod()) return false;
+    if (balance_period * 1000 <= loop_duration) return false;
+    if (velocity_period < balance_period || velocity_period > VELOCITY_PID_MAX_SAMPLE_PERIOD) return false;
+    if (!velocity_observer.isEnabled() && velocity_period < ENCODER_SAMPLE_PERIOD) return false;
+    return static_cast<uint16_t>(velocity_period) % static_cast<uint16_t>(balance_period) == 0;
+}
+
+/// Offsets and residual bias of the last calibration.
+Gyroscope::Calibration gyro_calibration{};
+
+/// Write integer values separated by commas.
+template <size_t LEN> void writeValues(char *buffer, const int32_t (&values)[LEN])
+{
+    buffer[0] = '\0';
+
+    for (size_t i = 0; i < LEN; i++)
+    {
+        if (i != 0) strcat(buffer, ",");
+        ltoa(values[i], buffer + strlen(buffer), 10);
+    }
+}
+
+/// Write accelerometer and gyroscope values as "<accel x>,<accel y>,<accel z>,<gyro x>,<gyro y>,<gyro z>".
+void writeGyroscopeOffsets(char *buffer, const Gyroscope::Offset &accel, const Gyroscope::Offset &gyro)
+{
+    const int32_t values[] = {accel.x, accel.y, accel.z, gyro.x, gyro.y, gyro.z};
+    writeValues(buffer, values);
+}
+
+/// Write the coefficients of the selected section of a filter as "<b0>,<b1>,<b2>,<a1>,<a2>".
+void writeBiquadSection(char *buffer, FilterIndex filter)
+{
+    const BiquadFilter::Section &section = filters[filter].getSection(filter_section);
+    const int16_t coefficients[] = {section.b0, section.b1, section.b2, section.a1, section.a2};
+
+    buffer[0] = '\0';
+
+    for (uint8_t i = 0; i < 5; i++)
+    {
+        if (i != 0) strcat(buffer, ",");
+        doubleToString(coefficients[i] / BiquadFilter::COEFFICIENT_ONE, 4, buffer + strlen(buffer));
+    }
+}
+
+/// Parse "<b0>,<b1>,<b2>,<a1>,<a2>" into the selected section of a filter, store it and apply it.
+/// Returns true if the coefficients are malformed, do not round into the Q2.14 range or make an unstable section.
+bool readBiquadSection(char *buffer, FilterIndex filter)
+{
+    int16_t coefficients[5];
+
+    for (uint8_t i = 0; i < 5; i++)
+    {
+        char *end = strchr(buffer, ',');
+
+        if ((end == nullptr) != (i == 4)) return true;
+        if (end != nullptr) *end = '\0';
+
+        double coefficient = stringToDouble(buffer);
+        if (isnan(coefficient) || abs(coefficient) > 2) return true;
+
+        // Values just below 2 round up to 32768, which would wrap around.
+        long rounded = lround(coefficient * BiquadFilter::COEFFICIENT_ONE);
+        if (rounded < INT16_MIN || rounded > INT16_MAX) return true;
+
+        coefficients[i] = rounded;
+        buffer = end + 1;
+    }
+
+    BiquadFilter::Section section{coefficients[0], coefficients[1], coefficients[2], coefficients[3], coefficients[4]};
+    if (!BiquadFilter::isStable(section)) return true;
+    eeprom_store.setBiquadSection(filter, filter_section, section);
+    filters[filter].setSection(filter_section, section);
+    return false;
+}
+
+/// Stream a system identification sample as
+/// "<sample>,<angle>,<angle rate>,<duty>,<excitation>,<left position>,<right position>",
+/// with the angle in 0.1 mrad, its rate in mrad/s and the positions in encoder pulses.
+void streamSystemIdentification(float angle, float angle_rate, int16_t duty, int16_t excitation)
+{
+    if (pending_baud_rate != 0) return;
+
+    char buffer[80];
+    const int32_t values[] = {
+        static_cast<int32_t>(system_identifier.getSample()),
+        static_cast<int32_t>(angle * 10000),
+        static_cast<int32_t>(angle_rate * 1000),
+        duty,
+        excitation,
+        encoder_left.getPosition(),
+        encoder_right.getPosition(),
+    };
+
+    writeValues(buffer, values);
+    comm_manager.stream(buffer);
+}
+
+#ifdef INTERRUPT_PROFILER
+/// Write the statistics of an interrupt vector as "<total cycles>,<count>,<max cycles>".
+void writeInterruptStats(char *buffer, InterruptProfiler::Vector vector)
+{
+    InterruptProfiler::Stats stats = InterruptProfiler::getStats(vector);
+
+    ultoa(stats.cycles, buffer, 10);
+    strcat(buffer, ",");
+    ultoa(stats.count, buffer + strlen(buffer), 10);
+    strcat(buffer, ",");
+    ultoa(stats.max_cycles, buffer + strlen(buffer), 10);
+}
+#endif
+
+/// Enable or disable the position hold loop, holding the current position when enabling it.
+void setPositionHold(bool enabled)
+{
+    if (enabled && !position_hold)
+    {
+        position_loop.setTarget(odometry.getDistance());
+        position_loop.enable();
+    }
+    else if (!enabled)
+    {
+        position_loop.disable();
+    }
+
+    position_hold = enabled;
+}
+
+/// Disable the control loops and coast the motors, the Supervisor arms them again once the robot has been held upright
+/// for STARTUP_TIME. Defined with the Supervisor.
+void disarm();
+
+/// Property names, kept in flash. The table stays in SRAM, its lambdas need dynamic initialization before C++17.
+static const char PROPERTY_S[] PROGMEM = "s";
+static const char PROPERTY_D[] PROGMEM = "d";
+static const char PROPERTY_SERIAL_BAUD[] PROGMEM = "serial.baud";
+static const char PROPERTY_SERIAL_DROPPED[] PROGMEM = "serial.dropped";
+static const char PROPERTY_COMM_BUDGET[] PROGMEM = "comm.budget";
+static const char PROPERTY_COMM_DEFERRED[] PROGMEM = "comm.deferred";
+static const char PROPERTY_LOOP_OVERRUNS[] PROGMEM = "loop.overruns";
+static const char PROPERTY_BOOT_EEPROM[] PROGMEM = "boot.eeprom";
+static const char PROPERTY_BOOT_SERIAL[] PROGMEM = "boot.serial";
+static const char PROPERTY_BOOT_GYROSCOPE[] PROGMEM = "boot.gyroscope";
+static const char PROPERTY_BOOT_TOTAL[] PROGMEM = "boot.total";
+static const char PROPERTY_BOOT_WARM[] PROGMEM = "boot.warm";
+static const char PROPERTY_FILTER_SECTION[] PROGMEM = "filter.section";
+static const char PROPERTY_FILTER_ANGLE[] PROGMEM = "filter.angle";
+static const char PROPERTY_FILTER_VELOCITY[] PROGMEM = "filter.velocity";
+static const char PROPERTY_FILTER_DUTY[] PROGMEM = "filter.duty";
+static const char PROPERTY_SYSID_ENABLE[] PROGMEM = "sysid.enable";
+static const char PROPERTY_SYSID_AMPLITUDE[] PROGMEM = "sysid.amplitude";
+static const char PROPERTY_SYSID_BIT_PERIOD[] PROGMEM = "sysid.bit-period";
+static const char PROPERTY_GYROSCOPE_ZERO_ANGLE[] PROGMEM = "gyroscope.zero-angle";
+static const char PROPERTY_GYROSCOPE_OFFSETS[] PROGMEM = "gyroscope.offsets";
+static const char PROPERTY_GYROSCOPE_RESIDUAL[] PROGMEM = "gyroscope.residual";
+static const char PROPERTY_GYROSCOPE_PERIOD[] PROGMEM = "gyroscope.period";
+static const char PROPERTY_GYROSCOPE_CALIBRATE[] PROGMEM = "gyroscope.calibrate";
+static const char PROPERTY_GAIN_PROFILE[] PROGMEM = "gain-profile";
+static const char PROPERTY_GAIN_PROFILE_BREAKPOINT[] PROGMEM = "gain-profile.breakpoint";
+static const char PROPERTY_GAIN_SCHEDULE[] PROGMEM = "gain-schedule";
+static const char PROPERTY_BALANCE_PID_KP[] PROGMEM = "balance-pid.kp";
+static const char PROPERTY_BALANCE_PID_KI[] PROGMEM = "balance-pid.ki";
+static const char PROPERTY_BALANCE_PID_KD[] PROGMEM = "balance-pid.kd";
+static const char PROPERTY_BALANCE_PID_D_ON_RATE[] PROGMEM = "balance-pid.d-on-rate";
+static const char PROPERTY_BALANCE_PID_PERIOD[] PROGMEM = "balance-pid.period";
+static const char PROPERTY_OBSERVER_ENABLE[] PROGMEM = "observer.enable";
+static const char PROPERTY_OBSERVER_BANDWIDTH[] PROGMEM = "observer.bandwidth";
+static const char PROPERTY_OBSERVER_STIFFNESS[] PROGMEM = "observer.stiffness";
+static const char PROPERTY_OBSERVER_DUTY_GAIN[] PROGMEM = "observer.duty-gain";
+static const char PROPERTY_OBSERVER_DISTURBANCE[] PROGMEM = "observer.disturbance";
+static const char PROPERTY_OBSERVER_COMPENSATION[] PROGMEM = "observer.compensation";
+static const char PROPERTY_PREDICTOR_HORIZON[] PROGMEM = "predictor.horizon";
+static const char PROPERTY_PREDICTOR_DUTY_GAIN[] PROGMEM = "predictor.duty-gain";
+static const char PROPERTY_VELOCITY_PID_KP[] PROGMEM = "velocity-pid.kp";
+static const char PROPERTY_VELOCITY_PID_KI[] PROGMEM = "velocity-pid.ki";
+static const char PROPERTY_VELOCITY_PID_KD[] PROGMEM = "velocity-pid.kd";
+static const char PROPERTY_VELOCITY_PID_PERIOD[] PROGMEM = "velocity-pid.period";
+static const char PROPERTY_VELOCITY_OBSERVER_ENABLE[] PROGMEM = "velocity-observer.enable";
+static const char PROPERTY_VELOCITY_OBSERVER_SPEED[] PROGMEM = "velocity-observer.speed";
+static const char PROPERTY_VELOCITY_OBSERVER_BIAS[] PROGMEM = "velocity-observer.bias";
+static const char PROPERTY_POSITION_PID_KP[] PROGMEM = "position-pid.kp";
+static const char PROPERTY_POSITION_PID_KI[] PROGMEM = "position-pid.ki";
+static const char PROPERTY_POSITION_PID_KD[] PROGMEM = "position-pid.kd";
+static const char PROPERTY_MOTION_MAX_ACCEL[] PROGMEM = "motion.max-accel";
+static const char PROPERTY_MOTION_MAX_JERK[] PROGMEM = "motion.max-jerk";
+static const char PROPERTY_MOTION_FEEDFORWARD[] PROGMEM = "motion.feedforward";
+static const char PROPERTY_MOTION_SPEED[] PROGMEM = "motion.speed";
+static const char PROPERTY_WHEEL_PID_KP[] PROGMEM = "wheel-pid.kp";
+static const char PROPERTY_WHEEL_PID_KI[] PROGMEM = "wheel-pid.ki";
+static const char PROPERTY_WHEEL_PID_STEERING[] PROGMEM = "wheel-pid.steering";
+static const char PROPERTY_MOTOR_TRIM_L[] PROGMEM = "motor.trim-l";
+static const char PROPERTY_MOTOR_TRIM_R[] PROGMEM = "motor.trim-r";
+static const char PROPERTY_POSITION_HOLD[] PROGMEM = "position.hold";
+static const char PROPERTY_POSITION_TARGET[] PROGMEM = "position.target";
+static const char PROPERTY_POSITION_MOVE[] PROGMEM = "position.move";
+static const char PROPERTY_BATTERY_VOLTAGE[] PROGMEM = "battery.voltage";
+static const char PROPERTY_BATTERY_COMPENSATION[] PROGMEM = "battery.compensation";
+static const char PROPERTY_IDLE_ENABLE[] PROGMEM = "idle.enable";
+static const char PROPERTY_IDLE_ACTIVE[] PROGMEM = "idle.active";
+static const char PROPERTY_ODOMETRY_DISTANCE[] PROGMEM = "odometry.distance";
+static const char PROPERTY_ODOMETRY_HEADING[] PROGMEM = "odometry.heading";
+static const char PROPERTY_IRQ_INT0[] PROGMEM = "irq.int0";
+static const char PROPERTY_IRQ_INT1[] PROGMEM = "irq.int1";
+static const char PROPERTY_IRQ_ADC[] PROGMEM = "irq.adc";
+static const char PROPERTY_IRQ_MAX_BLOCKED[] PROGMEM = "irq.max-blocked";
+static const char PROPERTY_IRQ_RESET[] PROGMEM = "irq.reset";
+static const char PROPERTY_ENCODER_MISSED_L[] PROGMEM = "encoder.missed-l";
+static const char PROPERTY_ENCODER_MISSED_R[] PROGMEM = "encoder.missed-r";
+static const char PROPERTY_LATENCY_MIN[] PROGMEM = "latency.min";
+static const char PROPERTY_LATENCY_MEAN[] PROGMEM = "latency.mean";
+static const char PROPERTY_LATENCY_MAX[] PROGMEM = "latency.max";
+static const char PROPERTY_LATENCY_P99[] PROGMEM = "latency.p99";
+static const char PROPERTY_LATENCY_ANGLE[] PROGMEM = "latency.angle";
+static const char PROPERTY_LATENCY_CONTROL[] PROGMEM = "latency.control";
+static const char PROPERTY_LATENCY_RESET[] PROGMEM = "latency.reset";
+
+Handler handlers[] = {
+    Handler{
+        .name = PROPERTY_S,
+        .get = nullptr,
+        .set =
+            [](char *buffer) {
+                double speed = stringToDouble(buffer);
+                if (isnan(speed)) return true;
+                setPositionHold(false);
+                motion_profile.setTarget(speed);
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_D,
+        .get = nullptr,
+        .set =
+            [](char *buffer) {
+                double dir = stringToDouble(buffer);
+                if (isnan(dir)) return true;
+                setPositionHold(false);
+                motion_profile.setTarget(dir);
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_SERIAL_BAUD,
+        .get = nullptr,
+        .set =
+            [](char *buffer) {
+                double baud_rate = stringToDouble(buffer);
+                if (isnan(baud_rate) || baud_rate < 1200 || baud_rate > 1000000) return true;
+                pending_baud_rate = baud_rate;
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_SERIAL_DROPPED,
+        .get =
+            [](char *buffer) {
+                ultoa(comm_manager.getDroppedPackets(), buffer, 10);
+                return false;
+            },
+        .set = nullptr,
+    },
+
+    Handler{
+        .name = PROPERTY_COMM_BUDGET,
+        .get =
+            [](char *buffer) {
+                ultoa(comm_tick_budget, buffer, 10);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double budget = stringToDouble(buffer);
+                if (isnan(budget) || budget < 1) return true;
+                comm_tick_budget = budget;
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_COMM_DEFERRED,
+        .get =
+            [](char *buffer) {
+                ultoa(comm_manager.getDeferredPackets(), buffer, 10);
+                return false;
+            },
+        .set = nullptr,
+    },
+
+    Handler{
+        .name = PROPERTY_LOOP_OVERRUNS,
+        .get =
+            [](char *buffer) {
+                ultoa(loop_overruns, buffer, 10);
+                return false;
+            },
+        .set = nullptr,
+    },
+
+    Handler{
+        .name = PROPERTY_BOOT_EEPROM,
+        .get =
+            [](char *buffer) {
+                ultoa(boot_times.eeprom, buffer, 10);
+                return false;
+            },
+        .set = nullptr,
+    },
+
+    Handler{
+        .name = PROPERTY_BOOT_SERIAL,
+        .get =
+            [](char *buffer) {
+                ultoa(boot_times.serial, buffer, 10);
+                return false;
+            },
+        .set = nullptr,
+    },
+
+    Handler{
+        .name = PROPERTY_BOOT_GYROSCOPE,
+        .get =
+            [](char *buffer) {
+                ultoa(boot_times.gyroscope, buffer, 10);
+                return false;
+            },
+        .set = nullptr,
+    },
+
+    Handler{
+        .name = PROPERTY_BOOT_TOTAL,
+        .get =
+            [](char *buffer) {
+                ultoa(boot_times.total, buffer, 10);
+                return false;
+            },
+        .set = nullptr,
+    },
+
+    Handler{
+        .name = PROPERTY_BOOT_WARM,
+        .get =
+            [](char *buffer) {
+                itoa(gyroscope.isWarmStart(), buffer, 10);
+                return false;
+            },
+        .set = nullptr,
+    },
+
+    Handler{
+        .name = PROPERTY_FILTER_SECTION,
+        .get =
+            [](char *buffer) {
+                itoa(filter_section, buffer, 10);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double index = stringToDouble(buffer);
+                if (isnan(index) || index < 0 || index >= BIQUAD_SECTIONS) return true;
+                filter_section = index;
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_FILTER_ANGLE,
+        .get =
+            [](char *buffer) {
+                writeBiquadSection(buffer, FILTER_ANGLE);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                return readBiquadSection(buffer, FILTER_ANGLE);
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_FILTER_VELOCITY,
+        .get =
+            [](char *buffer) {
+                writeBiquadSection(buffer, FILTER_VELOCITY);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                return readBiquadSection(buffer, FILTER_VELOCITY);
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_FILTER_DUTY,
+        .get =
+            [](char *buffer) {
+                writeBiquadSection(buffer, FILTER_DUTY);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                return readBiquadSection(buffer, FILTER_DUTY);
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_SYSID_ENABLE,
+        .get =
+            [](char *buffer) {
+                itoa(system_identifier.isEnabled(), buffer, 10);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double enable = stringToDouble(buffer);
+                if (isnan(enable)) return true;
+                if (enable != 0)
+                {
+                    system_identifier.enable();
+                }
+                else
+                {
+                    system_identifier.disable();
+                }
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_SYSID_AMPLITUDE,
+        .get =
+            [](char *buffer) {
+                itoa(system_identifier.getAmplitude(), buffer, 10);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double amplitude = stringToDouble(buffer);
+                if (isnan(amplitude) || amplitude < 0 || amplitude > INT8_MAX) return true;
+                system_identifier.setAmplitude(amplitude);
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_SYSID_BIT_PERIOD,
+        .get =
+            [](char *buffer) {
+                itoa(system_identifier.getBitPeriod(), buffer, 10);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double bit_period = stringToDouble(buffer);
+                if (isnan(bit_period) || bit_period < 1 || bit_period > UINT8_MAX) return true;
+                system_identifier.setBitPeriod(bit_period);
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_GYROSCOPE_ZERO_ANGLE,
+        .get =
+            [](char *buffer) {
+                doubleToString(gyroscope.getZeroAngle(), 2, buffer);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double zero_angle = stringToDouble(buffer);
+                if (isnan(zero_angle)) return true;
+                eeprom_store.setGyroZeroAngle(zero_angle);
+                gyroscope.setZeroAngle(zero_angle);
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_GYROSCOPE_OFFSETS,
+        .get =
+            [](char *buffer) {
+                writeGyroscopeOffsets(buffer, gyroscope.getOffsetAccel(), gyroscope.getOffsetGyro());
+                return false;
+            },
+        .set = nullptr,
+    },
+
+    Handler{
+        .name = PROPERTY_GYROSCOPE_RESIDUAL,
+        .get =
+            [](char *buffer) {
+                writeGyroscopeOffsets(buffer, gyro_calibration.residual_accel, gyro_calibration.residual_gyro);
+                return false;
+            },
+        .set = nullptr,
+    },
+
+    Handler{
+        .name = PROPERTY_GYROSCOPE_PERIOD,
+        .get =
+            [](char *buffer) {
+                doubleToString(gyroscope.getSamplePeriod(), 2, buffer);
+                return false;
+            },
+        .set = nullptr,
+    },
+
+    Handler{
+        .name = PROPERTY_GYROSCOPE_CALIBRATE,
+        .get = nullptr,
+        .set =
+            [](char *buffer) {
+                // Calibrating blocks for seconds with the robot held still at its balance point, where the Supervisor
+                // would arm the loops. It only arms them again once held upright for STARTUP_TIME after the call.
+                disarm();
+
+                Gyroscope::Calibration calibration;
+                if (!gyroscope.calibrate(STARTUP_ANGLE_RAD, calibration)) return true;
+
+                gyro_calibration = calibration;
+                eeprom_store.setGyroOffsetAccel(gyro_calibration.offset_accel);
+                eeprom_store.setGyroOffsetGyro(gyro_calibration.offset_gyro);
+                eeprom_store.setGyroZeroAngle(gyro_calibration.zero_angle);
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_GAIN_PROFILE,
+        .get =
+            [](char *buffer) {
+                itoa(gain_scheduler.getSelected(), buffer, 10);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double index = stringToDouble(buffer);
+                if (isnan(index) || index < 0 || index >= GAIN_PROFILE_COUNT) return true;
+                eeprom_store.setGainProfileIndex(index);
+                gain_scheduler.select(index);
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_GAIN_PROFILE_BREAKPOINT,
+        .get =
+            [](char *buffer) {
+                doubleToString(gain_scheduler.getSelectedProfile().breakpoint, 3, buffer);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double breakpoint = stringToDouble(buffer);
+                if (isnan(breakpoint)) return true;
+                gain_scheduler.getSelectedProfile().breakpoint = breakpoint;
+                eeprom_store.setGainProfile(gain_scheduler.getSelected(), gain_scheduler.getSelectedProfile());
+                gain_scheduler.apply();
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_GAIN_SCHEDULE,
+        .get =
+            [](char *buffer) {
+                itoa(static_cast<uint8_t>(gain_scheduler.getSource()), buffer, 10);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double source = stringToDouble(buffer);
+                if (isnan(source) || source < 0 || source > static_cast<uint8_t>(GainScheduler::Source::VOLTAGE))
+                    return true;
+                eeprom_store.setGainScheduleSource(static_cast<GainScheduler::Source>(source));
+                gain_scheduler.setSource(static_cast<GainScheduler::Source>(source));
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_BALANCE_PID_KP,
+        .get =
+            [](char *buffer) {
+                doubleToString(gain_scheduler.getSelectedProfile().balance_kp, 2, buffer);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double kp = stringToDouble(buffer);
+                if (isnan(kp)) return true;
+                gain_scheduler.getSelectedProfile().balance_kp = kp;
+                eeprom_store.setGainProfile(gain_scheduler.getSelected(), gain_scheduler.getSelectedProfile());
+                gain_scheduler.apply();
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_BALANCE_PID_KI,
+        .get =
+            [](char *buffer) {
+                doubleToString(gain_scheduler.getSelectedProfile().balance_ki, 2, buffer);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double ki = stringToDouble(buffer);
+                if (isnan(ki)) return true;
+                gain_scheduler.getSelectedProfile().balance_ki = ki;
+                eeprom_store.setGainProfile(gain_scheduler.getSelected(), gain_scheduler.getSelectedProfile());
+                gain_scheduler.apply();
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_BALANCE_PID_KD,
+        .get =
+            [](char *buffer) {
+                doubleToString(gain_scheduler.getSelectedProfile().balance_kd, 2, buffer);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double kd = stringToDouble(buffer);
+                if (isnan(kd)) return true;
+                gain_scheduler.getSelectedProfile().balance_kd = kd;
+                eeprom_store.setGainProfile(gain_scheduler.getSelected(), gain_scheduler.getSelectedProfile());
+                gain_scheduler.apply();
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_BALANCE_PID_D_ON_RATE,
+        .get =
+            [](char *buffer) {
+                itoa(balance_loop.getDerivativeOnRate(), buffer, 10);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double d_on_rate = stringToDouble(buffer);
+                if (isnan(d_on_rate)) return true;
+                eeprom_store.setBalancePIDDOnRate(d_on_rate != 0);
+                balance_loop.setDerivativeOnRate(d_on_rate != 0);
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_BALANCE_PID_PERIOD,
+        .get =
+            [](char *buffer) {
+                ultoa(balance_loop.getSamplePeriod(), buffer, 10);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double period = stringToDouble(buffer);
+                if (!validLoopPeriods(period, velocity_loop.getSamplePeriod())) return true;
+                eeprom_store.setBalancePIDSamplePeriod(period);
+                setLoopPeriods(period, velocity_loop.getSamplePeriod());
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_OBSERVER_ENABLE,
+        .get =
+            [](char *buffer) {
+                itoa(disturbance_observer.isEnabled(), buffer, 10);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double enabled = stringToDouble(buffer);
+                if (isnan(enabled)) return true;
+                eeprom_store.setObserverEnabled(enabled != 0);
+                disturbance_observer.setEnabled(enabled != 0);
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_OBSERVER_BANDWIDTH,
+        .get =
+            [](char *buffer) {
+                doubleToString(disturbance_observer.getBandwidth(), 2, buffer);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double bandwidth = stringToDouble(buffer);
+                if (isnan(bandwidth) || bandwidth < 0) return true;
+                eeprom_store.setObserverBandwidth(bandwidth);
+                disturbance_observer.setBandwidth(bandwidth);
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_OBSERVER_STIFFNESS,
+        .get =
+            [](char *buffer) {
+                doubleToString(disturbance_observer.getStiffness(), 2, buffer);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double stiffness = stringToDouble(buffer);
+                if (isnan(stiffness)) return true;
+                eeprom_store.setObserverStiffness(stiffness);
+                disturbance_observer.setStiffness(stiffness);
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_OBSERVER_DUTY_GAIN,
+        .get =
+            [](char *buffer) {
+                doubleToString(disturbance_observer.getDutyGain(), 4, buffer);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double duty_gain = stringToDouble(buffer);
+                if (isnan(duty_gain)) return true;
+                eeprom_store.setObserverDutyGain(duty_gain);
+                disturbance_observer.setDutyGain(duty_gain);
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_OBSERVER_DISTURBANCE,
+        .get =
+            [](char *buffer) {
+                doubleToString(disturbance_observer.getDisturbance(), 3, buffer);
+                return false;
+            },
+        .set = nullptr,
+    },
+
+    Handler{
+        .name = PROPERTY_OBSERVER_COMPENSATION,
+        .get =
+            [](char *buffer) {
+                doubleToString(disturbance_observer.getCompensation(), 2, buffer);
+                return false;
+            },
+        .set = nullptr,
+    },
+
+    Handler{
+        .name = PROPERTY_PREDICTOR_HORIZON,
+        .get =
+            [](char *buffer) {
+                doubleToString(angle_predictor.getHorizon(), 2, buffer);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double horizon = stringToDouble(buffer);
+                if (isnan(horizon) || horizon < 0) return true;
+                eeprom_store.setAnglePredictorHorizon(horizon);
+                angle_predictor.setHorizon(horizon);
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_PREDICTOR_DUTY_GAIN,
+        .get =
+            [](char *buffer) {
+                doubleToString(angle_predictor.getDutyGain(), 4, buffer);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double duty_gain = stringToDouble(buffer);
+                if (isnan(duty_gain)) return true;
+                eeprom_store.setAnglePredictorDutyGain(duty_gain);
+                angle_predictor.setDutyGain(duty_gain);
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_VELOCITY_PID_KP,
+        .get =
+            [](char *buffer) {
+                doubleToString(gain_scheduler.getSelectedProfile().velocity_kp, 8, buffer);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double kp = stringToDouble(buffer);
+                if (isnan(kp)) return true;
+                gain_scheduler.getSelectedProfile().velocity_kp = kp;
+                eeprom_store.setGainProfile(gain_scheduler.getSelected(), gain_scheduler.getSelectedProfile());
+                gain_scheduler.apply();
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_VELOCITY_PID_KI,
+        .get =
+            [](char *buffer) {
+                doubleToString(gain_scheduler.getSelectedProfile().velocity_ki, 8, buffer);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double ki = stringToDouble(buffer);
+                if (isnan(ki)) return true;
+                gain_scheduler.getSelectedProfile().velocity_ki = ki;
+                eeprom_store.setGainProfile(gain_scheduler.getSelected(), gain_scheduler.getSelectedProfile());
+                gain_scheduler.apply();
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_VELOCITY_PID_KD,
+        .get =
+            [](char *buffer) {
+                doubleToString(gain_scheduler.getSelectedProfile().velocity_kd, 8, buffer);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double kd = stringToDouble(buffer);
+                if (isnan(kd)) return true;
+                gain_scheduler.getSelectedProfile().velocity_kd = kd;
+                eeprom_store.setGainProfile(gain_scheduler.getSelected(), gain_scheduler.getSelectedProfile());
+                gain_scheduler.apply();
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_VELOCITY_PID_PERIOD,
+        .get =
+            [](char *buffer) {
+                ultoa(velocity_loop.getSamplePeriod(), buffer, 10);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double period = stringToDouble(buffer);
+                if (!validLoopPeriods(balance_loop.getSamplePeriod(), period)) return true;
+                eeprom_store.setVelocityPIDSamplePeriod(period);
+                setLoopPeriods(balance_loop.getSamplePeriod(), period);
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_VELOCITY_OBSERVER_ENABLE,
+        .get =
+            [](char *buffer) {
+                itoa(velocity_observer.isEnabled(), buffer, 10);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double enabled = stringToDouble(buffer);
+                if (isnan(enabled)) return true;
+                // The encoders would sample the velocity loop's shorter period, too short for a usable speed.
+                if (enabled == 0 && velocity_loop.getSamplePeriod() < ENCODER_SAMPLE_PERIOD) return true;
+                eeprom_store.setVelocityObserverEnabled(enabled != 0);
+                velocity_observer.setEnabled(enabled != 0);
+                velocity_observer.reset((encoder_left.getFrequency() + encoder_right.getFrequency()) / 2);
+                setLoopPeriods(balance_loop.getSamplePeriod(), velocity_loop.getSamplePeriod());
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_VELOCITY_OBSERVER_SPEED,
+        .get =
+            [](char *buffer) {
+                doubleToString(velocity_observer.getSpeed(), 3, buffer);
+                return false;
+            },
+        .set = nullptr,
+    },
+
+    Handler{
+        .name = PROPERTY_VELOCITY_OBSERVER_BIAS,
+        .get =
+            [](char *buffer) {
+                doubleToString(velocity_observer.getBias(), 2, buffer);
+                return false;
+            },
+        .set = nullptr,
+    },
+
+    Handler{
+        .name = PROPERTY_POSITION_PID_KP,
+        .get =
+            [](char *buffer) {
+                doubleToString(position_loop.getKp(), 4, buffer);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double kp = stringToDouble(buffer);
+                if (isnan(kp)) return true;
+                eeprom_store.setPositionPIDkP(kp);
+                position_loop.setKp(kp);
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_POSITION_PID_KI,
+        .get =
+            [](char *buffer) {
+                doubleToString(position_loop.getKi(), 4, buffer);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double ki = stringToDouble(buffer);
+                if (isnan(ki)) return true;
+                eeprom_store.setPositionPIDkI(ki);
+                position_loop.setKi(ki);
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_POSITION_PID_KD,
+        .get =
+            [](char *buffer) {
+                doubleToString(position_loop.getKd(), 4, buffer);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double kd = stringToDouble(buffer);
+                if (isnan(kd)) return true;
+                eeprom_store.setPositionPIDkD(kd);
+                position_loop.setKd(kd);
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_MOTION_MAX_ACCEL,
+        .get =
+            [](char *buffer) {
+                doubleToString(motion_profile.getMaxAcceleration(), 1, buffer);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double max_acceleration = stringToDouble(buffer);
+                if (isnan(max_acceleration) || max_acceleration < 0) return true;
+                eeprom_store.setMotionMaxAcceleration(max_acceleration);
+                motion_profile.setMaxAcceleration(max_acceleration);
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_MOTION_MAX_JERK,
+        .get =
+            [](char *buffer) {
+                doubleToString(motion_profile.getMaxJerk(), 1, buffer);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double max_jerk = stringToDouble(buffer);
+                if (isnan(max_jerk) || max_jerk < 0) return true;
+                eeprom_store.setMotionMaxJerk(max_jerk);
+                motion_profile.setMaxJerk(max_jerk);
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_MOTION_FEEDFORWARD,
+        .get =
+            [](char *buffer) {
+                itoa(motion_profile.getFeedforward(), buffer, 10);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double feedforward = stringToDouble(buffer);
+                if (isnan(feedforward)) return true;
+                eeprom_store.setMotionFeedforward(feedforward != 0);
+                motion_profile.setFeedforward(feedforward != 0);
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_MOTION_SPEED,
+        .get =
+            [](char *buffer) {
+                doubleToString(motion_profile.getSpeed(), 3, buffer);
+                return false;
+            },
+        .set = nullptr,
+    },
+
+    Handler{
+        .name = PROPERTY_WHEEL_PID_KP,
+        .get =
+            [](char *buffer) {
+                doubleToString(wheel_loop_left.getKp(), 4, buffer);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double kp = stringToDouble(buffer);
+                if (isnan(kp)) return true;
+                eeprom_store.setWheelPIDkP(kp);
+                wheel_loop_left.setKp(kp);
+                wheel_loop_right.setKp(kp);
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_WHEEL_PID_KI,
+        .get =
+            [](char *buffer) {
+                doubleToString(wheel_loop_left.getKi(), 4, buffer);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double ki = stringToDouble(buffer);
+                if (isnan(ki)) return true;
+                eeprom_store.setWheelPIDkI(ki);
+                wheel_loop_left.setKi(ki);
+                wheel_loop_right.setKi(ki);
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_WHEEL_PID_STEERING,
+        .get =
+            [](char *buffer) {
+                doubleToString(steering, 2, buffer);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double next = stringToDouble(buffer);
+                if (isnan(next)) return true;
+                // Only the wheel loops steer, refuse rather than silently ignore the request while they are off.
+                if (wheel_loop_left.getKp() == 0 && wheel_loop_left.getKi() == 0) return true;
+                steering = next;
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_MOTOR_TRIM_L,
+        .get =
+            [](char *buffer) {
+                doubleToString(motor_trim_left, 3, buffer);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double trim = stringToDouble(buffer);
+                if (isnan(trim) || trim < MOTOR_TRIM_MIN || trim > MOTOR_TRIM_MAX) return true;
+                eeprom_store.setMotorTrimLeft(trim);
+                motor_trim_left = trim;
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_MOTOR_TRIM_R,
+        .get =
+            [](char *buffer) {
+                doubleToString(motor_trim_right, 3, buffer);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double trim = stringToDouble(buffer);
+                if (isnan(trim) || trim < MOTOR_TRIM_MIN || trim > MOTOR_TRIM_MAX) return true;
+                eeprom_store.setMotorTrimRight(trim);
+                motor_trim_right = trim;
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_POSITION_HOLD,
+        .get =
+            [](char *buffer) {
+                itoa(position_hold, buffer, 10);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double hold = stringToDouble(buffer);
+                if (isnan(hold)) return true;
+                setPositionHold(hold != 0);
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_POSITION_TARGET,
+        .get =
+            [](char *buffer) {
+                doubleToString(position_loop.getTarget(), 3, buffer);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double target = stringToDouble(buffer);
+                if (isnan(target)) return true;
+                setPositionHold(true);
+                position_loop.setTarget(target);
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_POSITION_MOVE,
+        .get = nullptr,
+        .set =
+            [](char *buffer) {
+                double distance = stringToDouble(buffer);
+                if (isnan(distance)) return true;
+                setPositionHold(true);
+                position_loop.setTarget(position_loop.getTarget() + distance);
+                return false;
+            },
+    },
+
+    Handler{
+        .name = PROPERTY_BATTERY_VOLTAGE,
+        .get =
+            [](char *buffer) {
+                doubleToString(battery_monitor.getVoltage(), 2, buffer);
+                return false;
+            },
+        .set = nullptr,
+    },
+
+    Handler{
+        .name = PROPERTY_BATTERY_COMPENSATION,
+        .get =
+            [](char *buffer) {
+                itoa(battery_compensation, buffer, 10);
+                return false;
+            },
+        .set =
+            [](char *buffer) {
+                double compensation = stringToDouble(buffer);
+                if (isnan(compensation)) return true;
+                eeprom_store.setBatteryCompensation(compensation != 0);
+                battery_compensation = compensation != 0;
+                return false;
+            },
+    },
+
     Handler{
-        .name = "s",
-        .get = nullptr,
+        .name = PROPERTY_IDLE_ENABLE,
+        .get =
+            [](char *buffer) {
+                itoa(idle_enabled, buffer, 10);
+                return false;
+            },
         .set =
             [](char *buffer) {
-                double speed = stringToDouble(buffer);
-                if (isnan(speed)) return true;
-                velocity_loop.setTarget(speed);
+                double enabled = stringToDouble(buffer);
+                if (isnan(enabled)) return true;
+                eeprom_store.setIdleEnabled(enabled != 0);
+                idle_enabled = enabled != 0;
                 return false;
             },
     },
 
     Handler{
-        .name = "d",
-        .get = nullptr,
-        .set =
+        .name = PROPERTY_IDLE_ACTIVE,
+        .get =
             [](char *buffer) {
-                double dir = stringToDouble(buffer);
-                if (isnan(dir)) return true;
-                velocity_loop.setTarget(dir);
+                itoa(idle_active, buffer, 10);
                 return false;
             },
+        .set = nullptr,
     },
 
     Handler{
-        .name = "gyroscope.zero-angle",
+        .name = PROPERTY_ODOMETRY_DISTANCE,
         .get =
             [](char *buffer) {
-                dtostrf(gyroscope.getZeroAngle(), 0, 2, buffer);
+                doubleToString(odometry.getDistance(), 3, buffer);
                 return false;
             },
-        .set =
+        .set = nullptr,
+    },
+
+    Handler{
+        .name = PROPERTY_ODOMETRY_HEADING,
+        .get =
             [](char *buffer) {
-                double zero_angle = stringToDouble(buffer);
-                if (isnan(zero_angle)) return true;
-                eeprom_store.setGyroZeroAngle(zero_angle);
-                gyroscope.setZeroAngle(zero_angle);
+                doubleToString(odometry.getHeading(), 3, buffer);
                 return false;
             },
+        .set = nullptr,
     },
 
+#ifdef INTERRUPT_PROFILER
     Handler{
-        .name = "balance-pid.kp",
+        .name = PROPERTY_IRQ_INT0,
         .get =
             [](char *buffer) {
-                dtostrf(balance_loop.getKp(), 0, 2, buffer);
+                writeInterruptStats(buffer, InterruptProfiler::VECTOR_INT0);
                 return false;
             },
-        .set =
+        .set = nullptr,
+    },
+
+    Handler{
+        .name = PROPERTY_IRQ_INT1,
+        .get =
             [](char *buffer) {
-                double kp = stringToDouble(buffer);
-                if (isnan(kp)) return true;
-                eeprom_store.setBalancePIDkP(kp);
-                balance_loop.setKp(kp);
+                writeInterruptStats(buffer, InterruptProfiler::VECTOR_INT1);
                 return false;
             },
+        .set = nullptr,
     },
 
     Handler{
-        .name = "balance-pid.ki",
+        .name = PROPERTY_IRQ_ADC,
         .get =
             [](char *buffer) {
-                dtostrf(balance_loop.getKi(), 0, 2, buffer);
+                writeInterruptStats(buffer, InterruptProfiler::VECTOR_ADC);
                 return false;
             },
+        .set = nullptr,
+    },
+
+    Handler{
+        .name = PROPERTY_IRQ_MAX_BLOCKED,
+        .get =
+            [](char *buffer) {
+                ultoa(InterruptProfiler::getMaxBlocked(), buffer, 10);
+                return false;
+            },
+        .set = nullptr,
+    },
+
+    Handler{
+        .name = PROPERTY_IRQ_RESET,
+        .get = nullptr,
         .set =
             [](char *buffer) {
-                double ki = stringToDouble(buffer);
-                if (isnan(ki)) return true;
-                eeprom_store.setBalancePIDkI(ki);
-                balance_loop.setKi(ki);
+                InterruptProfiler::reset();
                 return false;
             },
     },
 
     Handler{
-        .name = "balance-pid.kd",
+        .name = PROPERTY_ENCODER_MISSED_L,
         .get =
             [](char *buffer) {
-                dtostrf(balance_loop.getKd(), 0, 2, buffer);
+                ultoa(encoder_left.getMissedPulses(), buffer, 10);
                 return false;
             },
-        .set =
+        .set = nullptr,
+    },
+
+    Handler{
+        .name = PROPERTY_ENCODER_MISSED_R,
+        .get =
             [](char *buffer) {
-                double kd = stringToDouble(buffer);
-                if (isnan(kd)) return true;
-                eeprom_store.setBalancePIDkD(kd);
-                balance_loop.setKd(kd);
+                ultoa(encoder_right.getMissedPulses(), buffer, 10);
                 return false;
             },
+        .set = nullptr,
     },
+#endif
 
+#ifdef LATENCY_PROBE
     Handler{
-        .name = "velocity-pid.kp",
+        .name = PROPERTY_LATENCY_MIN,
         .get =
             [](char *buffer) {
-                dtostrf(velocity_loop.getKp(), 0, 8, buffer);
+                ultoa(latency_probe.getMin(), buffer, 10);
                 return false;
             },
-        .set =
+        .set = nullptr,
+    },
+
+    Handler{
+        .name = PROPERTY_LATENCY_MEAN,
+        .get =
             [](char *buffer) {
-                double kp = stringToDouble(buffer);
-                if (isnan(kp)) return true;
-                eeprom_store.setVelocityPIDkP(kp);
-                velocity_loop.setKp(kp);
+                ultoa(latency_probe.getMean(), buffer, 10);
                 return false;
             },
+        .set = nullptr,
     },
 
     Handler{
-        .name = "velocity-pid.ki",
+        .name = PROPERTY_LATENCY_MAX,
         .get =
             [](char *buffer) {
-                dtostrf(velocity_loop.getKi(), 0, 8, buffer);
+                ultoa(latency_probe.getMax(), buffer, 10);
                 return false;
             },
-        .set =
+        .set = nullptr,
+    },
+
+    Handler{
+        .name = PROPERTY_LATENCY_P99,
+        .get =
             [](char *buffer) {
-                double ki = stringToDouble(buffer);
-                if (isnan(ki)) return true;
-                eeprom_store.setVelocityPIDkI(ki);
-                velocity_loop.setKi(ki);
+                ultoa(latency_probe.getPercentile99(), buffer, 10);
+                return false;
+            },
+        .set = nullptr,
+    },
+
+    Handler{
+        .name = PROPERTY_LATENCY_ANGLE,
+        .get =
+            [](char *buffer) {
+                ultoa(latency_probe.getStageDelay(LatencyProbe::ANGLE), buffer, 10);
                 return false;
             },
+        .set = nullptr,
     },
 
     Handler{
-        .name = "velocity-pid.kd",
+        .name = PROPERTY_LATENCY_CONTROL,
         .get =
             [](char *buffer) {
-                dtostrf(velocity_loop.getKd(), 0, 8, buffer);
+                ultoa(latency_probe.getStageDelay(LatencyProbe::CONTROL), buffer, 10);
                 return false;
             },
+        .set = nullptr,
+    },
+
+    Handler{
+        .name = PROPERTY_LATENCY_RESET,
+        .get = nullptr,
         .set =
             [](char *buffer) {
-                double kd = stringToDouble(buffer);
-                if (isnan(kd)) return true;
-                eeprom_store.setVelocityPIDkD(kd);
-                velocity_loop.setKd(kd);
+                latency_probe.reset();
                 return false;
             },
     },
+#endif
 };
 
 void loadEEPROM()
 {
     eeprom_store.initialize();
 
-    float balance_pid_kp = eeprom_store.getBalancePIDkP();
-    float balance_pid_ki = eeprom_store.getBalancePIDkI();
-    float balance_pid_kd = eeprom_store.getBalancePIDkD();
-    balance_loop.setKp(balance_pid_kp);
-    balance_loop.setKi(balance_pid_ki);
-    balance_loop.setKd(balance_pid_kd);
+    for (uint8_t i = 0; i < GAIN_PROFILE_COUNT; i++)
+    {
+        gain_scheduler.getProfile(i) = eeprom_store.getGainProfile(i);
+    }
+
+    GainScheduler::Source gain_schedule_source = eeprom_store.getGainScheduleSource();
+    uint8_t gain_profile_index = eeprom_store.getGainProfileIndex();
+    gain_scheduler.setSource(gain_schedule_source);
+    gain_scheduler.select(gain_profile_index);
+
+    bool velocity_observer_enabled = eeprom_store.getVelocityObserverEnabled();
+    velocity_observer.setEnabled(velocity_observer_enabled);
+
+    uint16_t balance_pid_sample_period = eeprom_store.getBalancePIDSamplePeriod();
+    uint16_t velocity_pid_sample_period = eeprom_store.getVelocityPIDSamplePeriod();
+
+    // A stored period shorter than the loop can sustain, or than the encoders need without the observer, falls back
+    // to the defaults.
+    if (balance_pid_sample_period < BALANCE_PID_MIN_SAMPLE_PERIOD ||
+        (!velocity_observer_enabled && velocity_pid_sample_period < ENCODER_SAMPLE_PERIOD))
+    {
+        balance_pid_sample_period = BALANCE_PID_SAMPLE_PERIOD;
+        velocity_pid_sample_period = VELOCITY_PID_SAMPLE_PERIOD;
+    }
+
+    setLoopPeriods(balance_pid_sample_period, velocity_pid_sample_period);
+
+    bool balance_pid_d_on_rate = eeprom_store.getBalancePIDDOnRate();
+    balance_loop.setDerivativeOnRate(balance_pid_d_on_rate);
+
+    bool observer_enabled = eeprom_store.getObserverEnabled();
+    float observer_bandwidth = eeprom_store.getObserverBandwidth();
+    float observer_stiffness = eeprom_store.getObserverStiffness();
+    float observer_duty_gain = eeprom_store.getObserverDutyGain();
+    disturbance_observer.setEnabled(observer_enabled);
+    disturbance_observer.setBandwidth(observer_bandwidth);
+    disturbance_observer.setStiffness(observer_stiffness);
+    disturbance_observer.setDutyGain(observer_duty_gain);
+
+    float angle_predictor_horizon = eeprom_store.getAnglePredictorHorizon();
+    float angle_predictor_duty_gain = eeprom_store.getAnglePredictorDutyGain();
+    angle_predictor.setHorizon(angle_predictor_horizon);
+    angle_predictor.setDutyGain(angle_predictor_duty_gain);
+
+    float position_pid_kp = eeprom_store.getPositionPIDkP();
+    float position_pid_ki = eeprom_store.getPositionPIDkI();
+    float position_pid_kd = eeprom_store.getPositionPIDkD();
+    position_loop.setKp(position_pid_kp);
+    position_loop.setKi(position_pid_ki);
+    position_loop.setKd(position_pid_kd);
+
+    float motion_max_acceleration = eeprom_store.getMotionMaxAcceleration();
+    float motion_max_jerk = eeprom_store.getMotionMaxJerk();
+    bool motion_feedforward = eeprom_store.getMotionFeedforward();
+    motion_profile.setMaxAcceleration(motion_max_acceleration);
+    motion_profile.setMaxJerk(motion_max_jerk);
+    motion_profile.setFeedforward(motion_feedforward);
+
+    float wheel_pid_kp = eeprom_store.getWheelPIDkP();
+    float wheel_pid_ki = eeprom_store.getWheelPIDkI();
+    wheel_loop_left.setTunings(wheel_pid_kp, wheel_pid_ki, 0);
+    wheel_loop_right.setTunings(wheel_pid_kp, wheel_pid_ki, 0);
+
+    motor_trim_left = eeprom_store.getMotorTrimLeft();
+    motor_trim_right = eeprom_store.getMotorTrimRight();
+
+    battery_compensation = eeprom_store.getBatteryCompensation();
+    idle_enabled = eeprom_store.getIdleEnabled();
 
-    float velocity_pid_kp = eeprom_store.getVelocityPIDkP();
-    float velocity_pid_ki = eeprom_store.getVelocityPIDkI();
-    float velocity_pid_kd = eeprom_store.getVelocityPIDkD();
-    velocity_loop.setKp(velocity_pid_kp);
-    velocity_loop.setKi(velocity_pid_ki);
-    velocity_loop.setKd(velocity_pid_kd);
+    for (uint8_t filter = 0; filter < EEPROMStore::BIQUAD_FILTER_COUNT; filter++)
+    {
+        for (uint8_t i = 0; i < BIQUAD_SECTIONS; i++)
+        {
+            filters[filter].setSection(i, eeprom_store.getBiquadSection(filter, i));
+        }
+    }
 
     float gyro_zero_angle = eeprom_store.getGyroZeroAngle();
+    Gyroscope::Offset gyro_offset_accel = eeprom_store.getGyroOffsetAccel();
+    Gyroscope::Offset gyro_offset_gyro = eeprom_store.getGyroOffsetGyro();
     gyroscope.setZeroAngle(gyro_zero_angle);
+    gyroscope.setOffsets(gyro_offset_accel, gyro_offset_gyro);
 }
 
 void setup()
 {
+    uint32_t phase_start = millis();
     loadEEPROM();
+    boot_times.eeprom = millis() - phase_start;
 
-    Serial.begin(9600);
+    phase_start = millis();
+    Serial.begin(SERIAL_BAUD_RATE);
     comm_manager.begin(&Serial, handlers);
+    boot_times.serial = millis() - phase_start;
 
+    phase_start = millis();
     gyroscope.begin();
+    boot_times.gyroscope = millis() - phase_start;
 
     motor_left.begin();
     motor_right.begin();
@@ -212,91 +1663,459 @@ void setup()
     encoder_left.begin();
     encoder_right.begin();
 
+    battery_monitor.begin();
+
+#ifdef LATENCY_PROBE
+    latency_probe.begin();
+#endif
+
+#ifdef INTERRUPT_PROFILER
+    InterruptProfiler::begin();
+#endif
+
     velocity_loop.enable();
+
+    // Measured from the end of the core initialization, the bootloader time is not included.
+    boot_times.total = millis();
 }
 
-void setStartedStopped(float angle)
+/// Signals exchanged by the control pipeline stages, held between passes.
+struct Signals
+{
+    /// [rad] Filtered inclination.
+    float angle;
+    /// [rad/s] Rate of change of the inclination.
+    float angle_rate;
+    /// Duty applied to both motors before the wheel corrections.
+    float duty;
+    /// Part of the duty added by the system identification excitation.
+    int16_t excitation;
+    /// Duty cancelling the estimated disturbance.
+    float compensation;
+};
+
+/// Sensor: polls the gyroscope for a new sample.
+struct AngleSensor
+{
+    static const Rate RATE = Rate::CYCLE;
+
+    static inline bool run(Signals &signals)
+    {
+        bool sampled = gyroscope.tick();
+        signals.angle_rate = gyroscope.getAngleRate();
+
+#ifdef LATENCY_PROBE
+        if (sampled)
+        {
+            latency_probe.mark(LatencyProbe::SAMPLE);
+        }
+#endif
+
+        return sampled;
+    }
+};
+
+/// Estimator: filters the inclination once per sensor sample, its last output holds in between.
+struct AngleEstimator
+{
+    static const Rate RATE = Rate::TRIGGERED;
+
+    static inline bool run(Signals &signals)
+    {
+        signals.angle = filters[FILTER_ANGLE].process(gyroscope.getAngle());
+
+#ifdef LATENCY_PROBE
+        latency_probe.mark(LatencyProbe::ANGLE);
+#endif
+
+        return true;
+    }
+};
+
+/// Estimator: integrates the forward acceleration of each sensor sample into the velocity estimate.
+struct VelocityEstimator
+{
+    static const Rate RATE = Rate::TRIGGERED;
+
+    static inline bool run(Signals &)
+    {
+        if (!velocity_observer.isEnabled())
+        {
+            return false;
+        }
+
+        velocity_observer.predict(gyroscope.getForwardAcceleration());
+        return true;
+    }
+};
+
+/// Controller: interpolates the loop gains from the scheduling variable.
+struct GainSchedule
 {
-    static bool starting_, started_ = false;
-    static uint32_t start_timestamp_;
+    static const Rate RATE = Rate::CYCLE;
+
+    static inline bool run(Signals &signals)
+    {
+        float speed_avg = (encoder_left.getFrequency() + encoder_right.getFrequency()) / 2;
+        gain_scheduler.update(signals.angle, speed_avg, battery_monitor.getVoltage());
+        return true;
+    }
+};
 
-    float abs_angle = abs(angle);
+/// Shaper: turns the speed and position requests into a speed trajectory and its lean feedforward.
+struct SpeedPlanner
+{
+    static const Rate RATE = Rate::CYCLE;
 
-    if (abs_angle > MAX_LEAN_ANGLE_RAD && started_)
+    static inline bool run(Signals &)
     {
-        balance_loop.disable();
-        velocity_loop.disable();
-        started_ = false;
+        odometry.update(encoder_left.getPosition(), encoder_right.getPosition());
+
+        if (position_hold && position_loop.compute(odometry.getDistance()))
+        {
+            motion_profile.setTarget(position_loop.getOutput());
+        }
+
+        // While stopped the trajectory holds at rest, so that the next start ramps up to the target.
+        if (!balance_loop.isEnabled())
+        {
+            motion_profile.reset();
+            return false;
+        }
+
+        // The lean feedforward follows the trajectory at the balance rate, between the velocity loop samples.
+        if (!motion_profile.tick())
+        {
+            return false;
+        }
+
+        velocity_loop.setTarget(motion_profile.getSpeed());
+        balance_loop.setTarget(velocity_loop.getOutput() + motion_profile.getLean());
+        return true;
     }
-    else if (!started_)
+};
+
+/// Controller: wheel speed loops and velocity loop, which sets the inclination target.
+struct VelocityController
+{
+    static const Rate RATE = Rate::CYCLE;
+
+    static bool encoder_l_ready, encoder_r_ready;
+
+    /// [rev/s] Filtered average speed of the last encoder sample.
+    static float measured_speed;
+
+    /// Consume the encoder sample once both encoders have one, returns whether they had.
+    static inline bool measure()
     {
-        if (abs_angle > STARTUP_ANGLE_RAD)
+        if (!encoder_l_ready)
+        {
+            encoder_l_ready = encoder_left.tick();
+        }
+
+        if (!encoder_r_ready)
+        {
+            encoder_r_ready = encoder_right.tick();
+        }
+
+        if (!encoder_l_ready || !encoder_r_ready)
         {
-            starting_ = false;
+            return false;
         }
 
-        if (!starting_)
+        encoder_l_ready = false;
+        encoder_r_ready = false;
+
+        float speed_l = encoder_left.getFrequency();
+        float speed_r = encoder_right.getFrequency();
+        measured_speed = filters[FILTER_VELOCITY].process((speed_l + speed_r) / 2);
+
+        // Each wheel follows the average speed offset by half the steering, the corrections of both wheels cancel
+        // out so the balance loop keeps the common mode.
+        float speed_mid = (speed_l + speed_r) / 2;
+        wheel_loop_left.setTarget(speed_mid + steering / 2);
+        wheel_loop_right.setTarget(speed_mid - steering / 2);
+        wheel_loop_left.compute(speed_l);
+        wheel_loop_right.compute(speed_r);
+
+        return true;
+    }
+
+    static inline bool run(Signals &)
+    {
+        bool measured = measure();
+        float speed = measured_speed;
+
+        // The observer runs the velocity loop on its estimate at the loop's own rate, otherwise the loop waits for
+        // the encoders, which sample at the same period.
+        if (velocity_observer.isEnabled())
+        {
+            if (measured) velocity_observer.correct(measured_speed);
+            speed = velocity_observer.getSpeed();
+        }
+        else if (!measured)
         {
-            starting_ = true;
-            start_timestamp_ = millis();
+            return false;
         }
 
-        if (millis() - start_timestamp_ > STARTUP_TIME)
+        if (!velocity_loop.compute(speed))
         {
-            balance_loop.enable();
-            velocity_loop.enable();
-            starting_ = false;
-            started_ = true;
+            return false;
         }
+
+        balance_loop.setTarget(velocity_loop.getOutput() + motion_profile.getLean());
+        return true;
     }
-}
+};
+
+bool VelocityController::encoder_l_ready = false;
+bool VelocityController::encoder_r_ready = false;
+float VelocityController::measured_speed = 0;
 
-void setDesiredAngle()
+/// Controller: balance loop on the predicted inclination.
+struct BalanceController
 {
-    static bool encoder_l_ready, encoder_r_ready = false;
+    static const Rate RATE = Rate::CYCLE;
 
-    if (!encoder_l_ready)
+    static inline bool run(Signals &signals)
     {
-        encoder_l_ready = encoder_left.tick();
+        float predicted_angle = angle_predictor.predict(signals.angle, signals.angle_rate, balance_loop.getOutput());
+
+        if (!balance_loop.compute(predicted_angle, signals.angle_rate))
+        {
+            return false;
+        }
+
+#ifdef LATENCY_PROBE
+        latency_probe.mark(LatencyProbe::CONTROL);
+#endif
+
+        return true;
     }
+};
+
+/// Estimator: estimates the external torque from the response to the previously applied duty.
+struct DisturbanceEstimator
+{
+    static const Rate RATE = Rate::TRIGGERED;
 
-    if (!encoder_r_ready)
+    static inline bool run(Signals &signals)
     {
-        encoder_r_ready = encoder_right.tick();
+        signals.compensation = disturbance_observer.update(signals.angle, signals.angle_rate, signals.duty);
+        return true;
     }
+};
+
+/// Shaper: filters the balance loop output, adds the excitation and the disturbance compensation, and compensates
+/// the battery voltage.
+struct DutyShaper
+{
+    static const Rate RATE = Rate::TRIGGERED;
 
-    if (encoder_l_ready && encoder_r_ready)
+    static inline bool run(Signals &signals)
     {
-        float speed_l = encoder_left.getFrequency();
-        float speed_r = encoder_right.getFrequency();
-        float speed_avg = (speed_l + speed_r) / 2;
+        // While identifying the system the excitation rides on top of the stabilizing output.
+        signals.excitation = system_identifier.next();
+        float duty = filters[FILTER_DUTY].process(balance_loop.getOutput()) + signals.excitation;
 
-        if (velocity_loop.compute(speed_avg))
+        if (battery_compensation)
         {
-            balance_loop.setTarget(velocity_loop.getOutput());
-            encoder_l_ready = false;
-            encoder_r_ready = false;
+            duty *= battery_monitor.getCompensation();
         }
+
+        // The observer models the applied duty, its compensation is not scaled for the battery voltage.
+        duty += signals.compensation;
+
+        signals.duty = constrain(duty, INT8_MIN, INT8_MAX);
+        return true;
     }
-}
+};
+
+/// Actuator: drives the motors with the trims and the wheel corrections.
+struct MotorActuator
+{
+    static const Rate RATE = Rate::TRIGGERED;
+
+    static inline bool run(Signals &signals)
+    {
+        float duty = signals.duty;
+        motor_left.setDuty(constrain(duty * motor_trim_left + wheel_loop_left.getOutput(), INT8_MIN, INT8_MAX));
+        motor_right.setDuty(constrain(duty * motor_trim_right + wheel_loop_right.getOutput(), INT8_MIN, INT8_MAX));
+
+#ifdef LATENCY_PROBE
+        latency_probe.mark(LatencyProbe::ACTUATION);
+#endif
+
+        if (system_identifier.isEnabled())
+        {
+            streamSystemIdentification(signals.angle, signals.angle_rate, duty, signals.excitation);
+        }
+
+        return true;
+    }
+};
 
-void setDesiredDuty(float angle)
+/// Supervisor: stops the loops when the robot falls and starts them once it has been held upright.
+struct Supervisor
 {
-    if (balance_loop.compute(angle))
+    static const Rate RATE = Rate::CYCLE;
+
+    static bool starting, started;
+    static uint32_t start_timestamp;
+
+    static inline bool run(Signals &signals)
     {
-        motor_left.setDuty(balance_loop.getOutput());
-        motor_right.setDuty(balance_loop.getOutput());
+        float abs_angle = abs(signals.angle);
+
+        if (abs_angle > MAX_LEAN_ANGLE_RAD && started)
+        {
+            disarm();
+        }
+        else if (!started)
+        {
+            if (abs_angle > STARTUP_ANGLE_RAD)
+            {
+                starting = false;
+            }
+
+            if (!starting)
+            {
+                starting = true;
+                start_timestamp = millis();
+            }
+
+            if (millis() - start_timestamp > STARTUP_TIME)
+            {
+                balance_loop.enable();
+                velocity_loop.enable();
+                if (position_hold) position_loop.enable();
+                wheel_loop_left.enable();
+                wheel_loop_right.enable();
+                starting = false;
+                started = true;
+            }
+        }
+
+        return started;
     }
+};
+
+bool Supervisor::starting = false;
+bool Supervisor::started = false;
+uint32_t Supervisor::start_timestamp = 0;
+
+void disarm()
+{
+    balance_loop.disable();
+    velocity_loop.disable();
+    position_loop.disable();
+    wheel_loop_left.disable();
+    wheel_loop_right.disable();
+    motion_profile.reset();
+    disturbance_observer.reset();
+    system_identifier.disable();
+    motor_left.coast();
+    motor_right.coast();
+    Supervisor::starting = false;
+    Supervisor::started = false;
 }
 
+/// Supervisor: sleeps between interrupts while the robot lies stopped.
+///
+/// The sensor keeps its sample rate: the DMP integrates the orientation at the rate it was configured for, and the
+/// angle that wakes the robot up must stay right.
+struct IdleManager
+{
+    static const Rate RATE = Rate::CYCLE;
+
+    static uint32_t active_timestamp;
+
+    /// Leave the idle mode, the robot must then stay stopped for IDLE_DELAY again before going back to it.
+    static inline void wake()
+    {
+        active_timestamp = millis();
+
+        idle_active = false;
+    }
+
+    static inline bool run(Signals &signals)
+    {
+        // Getting near upright wakes up for the startup delay.
+        if (!idle_enabled || Supervisor::started || abs(signals.angle) <= STARTUP_ANGLE_RAD)
+        {
+            wake();
+            return false;
+        }
+
+        if (!idle_active)
+        {
+            if (millis() - active_timestamp < IDLE_DELAY)
+            {
+                return false;
+            }
+
+            motor_left.coast();
+            motor_right.coast();
+            idle_active = true;
+        }
+
+        // Any interrupt ends the sleep: the serial link, the encoders, the ADC and the millis timer.
+        set_sleep_mode(SLEEP_MODE_IDLE);
+        sleep_mode();
+        return true;
+    }
+};
+
+uint32_t IdleManager::active_timestamp = 0;
+
+typedef Pipeline<Signals, AngleSensor, AngleEstimator, VelocityEstimator, GainSchedule, SpeedPlanner,
+                 VelocityController, BalanceController, DisturbanceEstimator, DutyShaper, MotorActuator, Supervisor,
+                 IdleManager>
+    ControlPipeline;
+
+Signals signals{};
+
 void loop()
 {
-    comm_manager.tick();
-    gyroscope.tick();
+    uint32_t loop_start = micros();
+
+    // Requests keep the idle mode off for IDLE_DELAY, so that tuning sessions do not wait on the sleeps.
+    if (Serial.available())
+    {
+        IdleManager::wake();
+    }
+
+    // Shed the serial requests first when the previous cycle overran the balance loop period, but only for a few
+    // cycles in a row so that a loop that always overruns can still be reconfigured.
+    bool overrun = loop_duration > balance_loop.getSamplePeriod() * 1000UL;
+
+    if (overrun)
+    {
+        loop_overruns++;
+    }
+
+    if (overrun && shed_cycles < COMM_MAX_SHED_CYCLES)
+    {
+        shed_cycles++;
+        comm_manager.tick(0);
+    }
+    else
+    {
+        shed_cycles = 0;
+        comm_manager.tick(comm_tick_budget);
+    }
+
+    // Switch the link rate once the last byte has left the transmitter, checked each cycle instead of waiting on
+    // Serial.flush() for up to a full buffer.
+    bool transmitted = Serial.availableForWrite() == SERIAL_TX_BUFFER_SIZE - 1 && (UCSR0A & (1 << TXC0));
+
+    if (pending_baud_rate != 0 && transmitted)
+    {
+        Serial.begin(pending_baud_rate);
+        pending_baud_rate = 0;
+    }
 
-    float angle = gyroscope.getAngle();
+    ControlPipeline::run(signals);
 
-    setDesiredAngle();
-    setDesiredDuty(angle);
-    setStartedStopped(angle);
+    loop_duration = micros() - loop_start;
 }